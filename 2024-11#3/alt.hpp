@@ -0,0 +1,109 @@
+#pragma once
+
+#include "../common/landmarks.hpp"
+#include "apsp.hpp"
+#include "csr.hpp"
+#include "mapf.hpp"
+
+// alt lower bounds over Map cells, rows and selection in common/landmarks.hpp
+struct Landmarks {
+    SlotMap slots;
+    LandmarkRows rows;
+
+    Landmarks() = default;
+
+    template <typename M> Landmarks(const M &map, int k) : slots(map) {
+        rows.build(map.adj, slots.slotOf, slots.cellOf, k);
+    }
+
+    bool enabled() const { return rows.enabled(); }
+    int count() const { return rows.cells.size(); }
+    size_t bytes() const { return rows.bytes(); }
+
+    // cell indices, -1 if the landmarks prove `to` unreachable from `from`
+    int bound(int from, int to) const {
+        if (from == to) { return 0; }
+        int32_t a = slots.slotOf[from], b = slots.slotOf[to];
+        if (a < 0 || b < 0) { return -1; }
+        return rows.bound(a, b);
+    }
+};
+
+/**
+ * plain A* between `queries` random pairs of accessible cells with no heuristic, the exact distance and alt bounds
+ * from 1, 2, 4, ... landmarks; reports expanded nodes per query and the bytes each heuristic keeps
+ */
+template <typename M> void benchAlt(const M &map, int queries, int maxLandmarks) {
+    SlotMap slots(map);
+    size_t size = map.rows * map.cols;
+    std::mt19937 rng(42);
+    uniform_int_distribution<int> pick(0, slots.size() - 1);
+    vector<pair<int32_t, int32_t>> pairs(queries);
+    for (auto &[from, to] : pairs) { from = slots.cellOf[pick(rng)], to = slots.cellOf[pick(rng)]; }
+    cerr << "alt map " << map.rows << "x" << map.cols << " accessible " << slots.size() << endl;
+
+    vector<int32_t> g(size), exact(size);
+    vector<uint32_t> seen(size, 0), closed(size, 0);
+    uint32_t stamp = 0;
+    // h returns -1 for unreachable
+    auto search = [&](int32_t from, int32_t to, auto &&h) {
+        stamp++;
+        int expanded = 0;
+        priority_queue<pair<int32_t, int32_t>, vector<pair<int32_t, int32_t>>, greater<>> open;
+        int32_t h0 = h(from);
+        if (h0 < 0) { return expanded; }
+        g[from] = 0;
+        seen[from] = stamp;
+        open.emplace(h0, from);
+        while (!open.empty()) {
+            auto [f, u] = open.top();
+            open.pop();
+            if (closed[u] == stamp) { continue; }
+            closed[u] = stamp;
+            expanded++;
+            if (u == to) { break; }
+            for (int32_t v : map.adj[u]) {
+                if (seen[v] == stamp && g[v] <= g[u] + 1) { continue; }
+                int32_t hv = h(v);
+                if (hv < 0) { continue; }
+                seen[v] = stamp;
+                g[v] = g[u] + 1;
+                open.emplace(g[v] + hv, v);
+            }
+        }
+        return expanded;
+    };
+    auto run = [&](const string &name, size_t bytes, auto &&prepare, auto &&h) {
+        int64_t expanded = 0;
+        double us = 0;
+        for (auto [from, to] : pairs) {
+            prepare(to);
+            auto start = std::chrono::steady_clock::now();
+            expanded += search(from, to, [&](int32_t u) { return h(u, to); });
+            us += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        }
+        cerr << "alt heuristic " << name << " bytes " << bytes << " expanded/query " << (double)expanded / queries
+             << " us/query " << us / queries << endl;
+    };
+
+    auto none = [](int32_t) {};
+    run("none", 0, none, [](int32_t, int32_t) { return 0; });
+    // the goal's bfs row stands in for a full table lookup, built outside the timer
+    run("exact", (size_t)slots.size() * slots.size() * sizeof(uint16_t),
+        [&](int32_t to) {
+            std::fill(exact.begin(), exact.end(), -1);
+            vector<int32_t> q = {to};
+            exact[to] = 0;
+            for (size_t head = 0; head < q.size(); head++) {
+                for (int32_t v : map.adj[q[head]]) {
+                    if (exact[v] == -1) { exact[v] = exact[q[head]] + 1, q.push_back(v); }
+                }
+            }
+        },
+        [&](int32_t u, int32_t) { return exact[u]; });
+    for (int k = 1; k <= maxLandmarks; k *= 2) {
+        Landmarks alt(map, k);
+        run("landmarks-" + std::to_string(k), alt.bytes(), none,
+            [&](int32_t u, int32_t to) { return alt.bound(u, to); });
+    }
+}
@@ -0,0 +1,205 @@
+#pragma once
+
+#include "csr.hpp"
+#include "mapf.hpp"
+
+enum class ApspBackend { Queue, Bitboard };
+
+// dense numbering of the accessible cells, walls map to -1
+struct SlotMap {
+    vector<int32_t> slotOf;
+    vector<int32_t> cellOf;
+
+    SlotMap() = default;
+
+    template <typename M> explicit SlotMap(const M &map) : slotOf(map.rows * map.cols, -1) {
+        for (int index = 0; index < map.rows * map.cols; index++) {
+            auto [r, c] = map.toCoord(index);
+            if (!map.isAccessible(r, c)) { continue; }
+            slotOf[index] = cellOf.size();
+            cellOf.push_back(index);
+        }
+    }
+
+    int size() const { return cellOf.size(); }
+};
+
+/**
+ * all-pairs distances by one bfs per accessible cell
+ * table is slots * slots, row-major by slot, `unreachable` where no path exists
+ * sources are handed out to `threads` workers (0 -> hardware_concurrency) through an atomic counter
+ * false and nothing written when a distance could reach `unreachable`, i.e. with `unreachable` or more slots
+ */
+inline bool bfsApsp(const Csr &adj, const SlotMap &slots, uint16_t *table, uint16_t unreachable, int threads) {
+    int n = slots.size();
+    if (n >= unreachable) { return false; }
+    std::fill(table, table + (size_t)n * n, unreachable);
+    if (threads <= 0) { threads = max<int>(1, std::thread::hardware_concurrency()); }
+    threads = min(threads, max<int>(1, n));
+
+    std::atomic<int32_t> next = 0;
+    auto worker = [&]() {
+        vector<int32_t> q(n);
+        for (int32_t s = next++; s < n; s = next++) {
+            uint16_t *row = table + (size_t)s * n;
+            int head = 0, tail = 0;
+            row[s] = 0;
+            q[tail++] = slots.cellOf[s];
+            while (head < tail) {
+                int32_t u = q[head++];
+                uint16_t du = row[slots.slotOf[u]];
+                for (int32_t v : adj[u]) {
+                    uint16_t &dv = row[slots.slotOf[v]];
+                    if (dv != unreachable) { continue; }
+                    dv = du + 1;
+                    q[tail++] = v;
+                }
+            }
+        }
+    };
+
+    vector<std::thread> workers;
+    for (int i = 1; i < threads; i++) { workers.emplace_back(worker); }
+    worker();
+    for (auto &t : workers) { t.join(); }
+    return true;
+}
+
+/**
+ * the same table and the same limit with a bit-parallel wavefront instead of a queue
+ * free cells and the frontier are 64-bit rows padded by a zero word on every side, one layer is
+ * next = (front | front << 1 | front >> 1 | up | down) & free & ~seen, O(rows * cols / 64) words, AVX2 wide if enabled
+ */
+template <typename M>
+bool bitBfsApsp(const M &map, const SlotMap &slots, uint16_t *table, uint16_t unreachable, int threads) {
+    int n = slots.size();
+    if (n >= unreachable) { return false; }
+    std::fill(table, table + (size_t)n * n, unreachable);
+    if (threads <= 0) { threads = max<int>(1, std::thread::hardware_concurrency()); }
+    threads = min(threads, max<int>(1, n));
+
+    int stride = (map.cols + 63) / 64 + 2;
+    size_t words = (size_t)(map.rows + 2) * stride;
+    auto wordOf = [&](int r, int c) { return (size_t)(r + 1) * stride + 1 + c / 64; };
+    vector<uint64_t> free(words, 0);
+    for (int32_t cell : slots.cellOf) {
+        auto [r, c] = map.toCoord(cell);
+        free[wordOf(r, c)] |= 1ULL << (c % 64);
+    }
+
+    // next over the interior rows, the padding stays zero; returns whether anything was reached
+    auto expand = [&](const uint64_t *front, const uint64_t *seen, uint64_t *next) {
+        size_t i = stride, end = words - stride;
+        uint64_t any = 0;
+#ifdef __AVX2__
+        __m256i anyV = _mm256_setzero_si256();
+        auto load = [](const uint64_t *p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)); };
+        for (; i + 4 <= end; i += 4) {
+            __m256i f = load(front + i);
+            __m256i left = _mm256_or_si256(_mm256_slli_epi64(f, 1), _mm256_srli_epi64(load(front + i - 1), 63));
+            __m256i right = _mm256_or_si256(_mm256_srli_epi64(f, 1), _mm256_slli_epi64(load(front + i + 1), 63));
+            __m256i vertical = _mm256_or_si256(load(front + i - stride), load(front + i + stride));
+            __m256i reach = _mm256_or_si256(_mm256_or_si256(f, left), _mm256_or_si256(right, vertical));
+            reach = _mm256_andnot_si256(load(seen + i), _mm256_and_si256(reach, load(free.data() + i)));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(next + i), reach);
+            anyV = _mm256_or_si256(anyV, reach);
+        }
+        any = !_mm256_testz_si256(anyV, anyV);
+#endif
+        for (; i < end; i++) {
+            uint64_t f = front[i];
+            uint64_t reach = f | (f << 1) | (front[i - 1] >> 63) | (f >> 1) | (front[i + 1] << 63) |
+                             front[i - stride] | front[i + stride];
+            next[i] = reach & free[i] & ~seen[i];
+            any |= next[i];
+        }
+        return any != 0;
+    };
+
+    std::atomic<int32_t> next = 0;
+    auto worker = [&]() {
+        vector<uint64_t> front(words), reached(words), seen(words);
+        for (int32_t s = next++; s < n; s = next++) {
+            uint16_t *row = table + (size_t)s * n;
+            auto [r, c] = map.toCoord(slots.cellOf[s]);
+            std::fill(front.begin(), front.end(), 0);
+            std::fill(seen.begin(), seen.end(), 0);
+            front[wordOf(r, c)] = seen[wordOf(r, c)] = 1ULL << (c % 64);
+            row[s] = 0;
+            for (uint16_t d = 1; expand(front.data(), seen.data(), reached.data()); d++) {
+                for (size_t i = stride; i < words - stride; i++) {
+                    uint64_t bits = reached[i];
+                    seen[i] |= bits;
+                    for (; bits; bits &= bits - 1) {
+                        int32_t rr = i / stride - 1;
+                        int32_t cc = (i % stride - 1) * 64 + std::countr_zero(bits);
+                        row[slots.slotOf[map.toIndex(rr, cc)]] = d;
+                    }
+                }
+                std::swap(front, reached);
+            }
+        }
+    };
+
+    vector<std::thread> workers;
+    for (int i = 1; i < threads; i++) { workers.emplace_back(worker); }
+    worker();
+    for (auto &t : workers) { t.join(); }
+    return true;
+}
+
+// the previous O(V^3) build over every cell, kept to benchmark against
+template <typename M> vector<int> floydWarshall(const M &map, int inf) {
+    int size = map.rows * map.cols;
+    vector<int> floyd((size_t)size * size, inf);
+    for (int i = 0; i < size; i++) {
+        auto [r, c] = map.toCoord(i);
+        if (!map.isAccessible(r, c)) { continue; }
+        floyd[i * size + i] = 0;
+        for (int v : map.adj[i]) { floyd[i * size + v] = 1; }
+    }
+    for (int k = 0; k < size; k++) {
+        for (int i = 0; i < size; i++) {
+            int *fi = floyd.data() + i * size;
+            int fik = fi[k];
+            const int *fk = floyd.data() + k * size;
+            for (int j = 0; j < size; j++) { fi[j] = min(fi[j], fik + fk[j]); }
+        }
+    }
+    return floyd;
+}
+
+// time the bfs build of F (a FloydMap) per backend at 1, 2, 4, ... threads against floydWarshall and check they agree
+template <typename F, typename M> void benchApsp(const M &map, int inf) {
+    auto timeUs = [](auto &&fn) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    vector<int> expect;
+    double us = timeUs([&]() { expect = floydWarshall(map, inf); });
+    cerr << "floyd-warshall us " << us << " bytes " << expect.size() * sizeof(int) << endl;
+
+    int maxThreads = max<int>(1, std::thread::hardware_concurrency());
+    int size = map.rows * map.cols;
+    for (auto [backend, name] : {pair{ApspBackend::Queue, "queue"}, pair{ApspBackend::Bitboard, "bitboard"}}) {
+        for (int threads = 1;; threads = min(threads * 2, maxThreads)) {
+            double us = timeUs([&]() { F floyd(map, "", 0, threads, backend); });
+            cerr << name << " apsp threads " << threads << " us " << us << endl;
+            if (threads == maxThreads) { break; }
+        }
+
+        F floyd(map, "", 0, maxThreads, backend);
+        int mismatches = 0;
+        for (int i = 0; i < size; i++) {
+            auto [r1, c1] = map.toCoord(i);
+            for (int j = 0; j < size; j++) {
+                auto [r2, c2] = map.toCoord(j);
+                if (floyd.distance(r1, c1, r2, c2) != expect[i * size + j]) { mismatches++; }
+            }
+        }
+        cerr << name << " apsp bytes " << (size_t)floyd.slots.size() * floyd.slots.size() * sizeof(uint16_t)
+             << " mismatches " << mismatches << endl;
+    }
+}
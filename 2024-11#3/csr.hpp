@@ -0,0 +1,27 @@
+#pragma once
+
+#include "mapf.hpp"
+
+// compressed sparse row adjacency, neighbours of u are targets[offsets[u], offsets[u + 1])
+struct Csr {
+    vector<int32_t> offsets = {0};
+    vector<int32_t> targets;
+
+    int nodes() const { return offsets.size() - 1; }
+    int degree(int u) const { return offsets[u + 1] - offsets[u]; }
+
+    std::span<const int32_t> operator[](int u) const {
+        return {targets.data() + offsets[u], targets.data() + offsets[u + 1]};
+    }
+
+    // forEach(u, emit) calls emit(v) once per edge u -> v
+    template <typename F> void build(int nodes, F &&forEach) {
+        offsets.assign(nodes + 1, 0);
+        targets.clear();
+        for (int u = 0; u < nodes; u++) {
+            forEach(u, [&](int v) { targets.push_back(v); });
+            offsets[u + 1] = targets.size();
+        }
+        targets.shrink_to_fit();
+    }
+};
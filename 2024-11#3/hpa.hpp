@@ -0,0 +1,378 @@
+#pragma once
+
+#include "csr.hpp"
+#include "mapf.hpp"
+
+/**
+ * hierarchical path finding (hpa*) over a grid map
+ * the map is cut into clusterSize x clusterSize clusters, every maximal run of open cell pairs along a cluster border
+ * is an entrance with one transition in its middle, or one at each end when it is long
+ * transition cells are the abstract nodes, joined by the step across the border and by intra-cluster bfs distances
+ * whose cell paths are cached
+ * a query links its endpoints to the nodes of their clusters, runs A* on the abstract graph and only splices cached
+ * segments into a cell path as far as the caller asks; costs are near optimal, not exact
+ * nothing routes through it yet, only benchHpa runs it, under BENCH_HPA in the mapf mains
+ */
+struct Hpa {
+    static constexpr int32_t NONE = -1;
+    static constexpr int LONG_ENTRANCE = 6; // runs at least this long get a transition at both ends
+
+    struct Edge {
+        int32_t to;
+        int32_t cost;
+        int32_t segment; // index into segments, NONE for the step across a border
+    };
+
+    int rows = 0;
+    int cols = 0;
+    int clusterSize = 0;
+    int clusterCols = 0;
+    Csr adj;
+    vector<int32_t> nodeOf; // cell -> abstract node
+    vector<int32_t> cellOf; // abstract node -> cell
+    matrix<int32_t> clusterNodes;
+    vector<vector<Edge>> edges;
+    matrix<int32_t> segments; // both ends included
+
+    // query scratch, stamped instead of cleared; side 0 is rooted at the source, side 1 at the goal
+    struct Local {
+        vector<int32_t> dist;
+        vector<int32_t> prev;
+        vector<uint32_t> seen;
+    } local[2];
+    vector<int32_t> g;
+    vector<int32_t> parent;
+    vector<int32_t> via;
+    vector<uint32_t> opened;
+    uint32_t stamp = 0;
+    vector<int32_t> route; // abstract nodes of the last search, empty when it went straight inside one cluster
+    int expanded = 0;
+
+    Hpa() = default;
+
+    template <typename M> Hpa(const M &map, int clusterSize)
+        : rows(map.rows), cols(map.cols), clusterSize(clusterSize),
+          clusterCols((map.cols + clusterSize - 1) / clusterSize),
+          adj(map.adj), nodeOf(map.rows * map.cols, NONE),
+          clusterNodes((size_t)((map.rows + clusterSize - 1) / clusterSize) * clusterCols) {
+        for (auto &side : local) {
+            side.dist.assign(rows * cols, 0);
+            side.prev.assign(rows * cols, NONE);
+            side.seen.assign(rows * cols, 0);
+        }
+
+        auto open = [&](int r, int c) { return map.isAccessible(r, c); };
+        auto node = [&](int cell) {
+            if (nodeOf[cell] == NONE) {
+                nodeOf[cell] = cellOf.size();
+                cellOf.push_back(cell);
+                clusterNodes[clusterOf(cell)].push_back(nodeOf[cell]);
+                edges.emplace_back();
+            }
+            return nodeOf[cell];
+        };
+        auto transition = [&](int a, int b) {
+            int u = node(a), v = node(b);
+            edges[u].push_back({(int32_t)v, 1, NONE});
+            edges[v].push_back({(int32_t)u, 1, NONE});
+        };
+        // scan a border of `length` cells, at(i) gives the pair of cells facing each other across it
+        auto entrances = [&](int length, auto at) {
+            int start = -1;
+            for (int i = 0; i <= length; i++) {
+                bool pass = false;
+                if (i < length) {
+                    auto [a, b] = at(i);
+                    pass = open(a / cols, a % cols) && open(b / cols, b % cols);
+                }
+                if (pass && start == -1) { start = i; }
+                if (pass || start == -1) { continue; }
+                int end = i - 1;
+                if (end - start + 1 >= LONG_ENTRANCE) {
+                    transition(at(start).first, at(start).second);
+                    transition(at(end).first, at(end).second);
+                } else {
+                    auto [a, b] = at((start + end) / 2);
+                    transition(a, b);
+                }
+                start = -1;
+            }
+        };
+        for (int r0 = 0; r0 < rows; r0 += clusterSize) {
+            for (int c0 = 0; c0 < cols; c0 += clusterSize) {
+                int height = min(clusterSize, rows - r0), width = min(clusterSize, cols - c0);
+                if (c0 + clusterSize < cols) {
+                    int c = c0 + clusterSize - 1;
+                    entrances(height, [&](int i) { return pii{(r0 + i) * cols + c, (r0 + i) * cols + c + 1}; });
+                }
+                if (r0 + clusterSize < rows) {
+                    int r = r0 + clusterSize - 1;
+                    entrances(width, [&](int i) { return pii{r * cols + c0 + i, (r + 1) * cols + c0 + i}; });
+                }
+            }
+        }
+
+        // intra-cluster edges, one bfs per node
+        for (int u = 0; u < (int)cellOf.size(); u++) {
+            stamp++;
+            clusterBfs(0, cellOf[u]);
+            for (int32_t v : clusterNodes[clusterOf(cellOf[u])]) {
+                if (v == u || local[0].seen[cellOf[v]] != stamp) { continue; }
+                vector<int32_t> segment;
+                for (int32_t cell = cellOf[v]; cell != NONE; cell = local[0].prev[cell]) { segment.push_back(cell); }
+                reverse(segment);
+                edges[u].push_back({v, local[0].dist[cellOf[v]], (int32_t)segments.size()});
+                segments.push_back(std::move(segment));
+            }
+        }
+
+        g.assign(cellOf.size(), 0);
+        parent.assign(cellOf.size(), NONE);
+        via.assign(cellOf.size(), NONE);
+        opened.assign(cellOf.size(), 0);
+    }
+
+    int clusterOf(int cell) const { return (cell / cols / clusterSize) * clusterCols + cell % cols / clusterSize; }
+    int nodes() const { return cellOf.size(); }
+
+    size_t bytes() const {
+        size_t total = adj.offsets.size() * sizeof(int32_t) + adj.targets.size() * sizeof(int32_t);
+        total += (nodeOf.size() + cellOf.size()) * sizeof(int32_t);
+        for (const auto &e : edges) { total += e.size() * sizeof(Edge); }
+        for (const auto &s : segments) { total += s.size() * sizeof(int32_t); }
+        return total;
+    }
+
+    // cells of `root`'s cluster by distance from root, prev points back towards root
+    void clusterBfs(int side, int root) {
+        auto &[dist, prev, seen] = local[side];
+        int cluster = clusterOf(root);
+        vector<int32_t> &q = side == 0 ? queue0 : queue1;
+        q.clear();
+        q.push_back(root);
+        seen[root] = stamp;
+        dist[root] = 0;
+        prev[root] = NONE;
+        for (size_t head = 0; head < q.size(); head++) {
+            int32_t u = q[head];
+            for (int32_t v : adj[u]) {
+                if (seen[v] == stamp || clusterOf(v) != cluster) { continue; }
+                seen[v] = stamp;
+                dist[v] = dist[u] + 1;
+                prev[v] = u;
+                q.push_back(v);
+            }
+        }
+    }
+
+    // abstract cost from cell `from` to cell `to`, -1 if unreachable; fills route for refine()
+    int search(int from, int to) {
+        route.clear();
+        expanded = 0;
+        stamp++;
+        if (adj.degree(from) == 0 || adj.degree(to) == 0) { return from == to ? 0 : -1; }
+        clusterBfs(0, from);
+        clusterBfs(1, to);
+
+        int best = INT32_MAX;
+        int32_t goal = NONE;
+        if (clusterOf(from) == clusterOf(to) && local[0].seen[to] == stamp) { best = local[0].dist[to]; }
+
+        auto h = [&](int32_t u) {
+            return (int32_t)(std::abs(cellOf[u] / cols - to / cols) + std::abs(cellOf[u] % cols - to % cols));
+        };
+        priority_queue<pair<int32_t, int32_t>, vector<pair<int32_t, int32_t>>, greater<>> open;
+        auto push = [&](int32_t u, int32_t cost, int32_t from, int32_t segment) {
+            if (opened[u] == stamp && g[u] <= cost) { return; }
+            opened[u] = stamp;
+            g[u] = cost;
+            parent[u] = from;
+            via[u] = segment;
+            open.emplace(cost + h(u), u);
+        };
+        for (int32_t u : clusterNodes[clusterOf(from)]) {
+            if (local[0].seen[cellOf[u]] == stamp) { push(u, local[0].dist[cellOf[u]], NONE, NONE); }
+        }
+        while (!open.empty()) {
+            auto [f, u] = open.top();
+            open.pop();
+            if (f >= best) { break; }
+            if (f != g[u] + h(u)) { continue; }
+            expanded++;
+            if (local[1].seen[cellOf[u]] == stamp && g[u] + local[1].dist[cellOf[u]] < best) {
+                best = g[u] + local[1].dist[cellOf[u]];
+                goal = u;
+            }
+            for (auto [v, cost, segment] : edges[u]) { push(v, g[u] + cost, u, segment); }
+        }
+
+        if (best == INT32_MAX) { return -1; }
+        for (int32_t u = goal; u != NONE; u = parent[u]) { route.push_back(u); }
+        reverse(route);
+        return best;
+    }
+
+    /**
+     * cell path of the last search, stopping once it holds `maxSteps` moves (-1 for all of it)
+     * only the segments that reach into the prefix are expanded
+     */
+    vector<int32_t> refine(int from, int to, int maxSteps = -1) const {
+        vector<int32_t> cells;
+        auto full = [&]() { return maxSteps >= 0 && (int)cells.size() > maxSteps; };
+        auto backTo = [&](int32_t cell) {
+            vector<int32_t> part;
+            for (; cell != from; cell = local[0].prev[cell]) { part.push_back(cell); }
+            cells.push_back(from);
+            for (auto it = part.rbegin(); it != part.rend() && !full(); it++) { cells.push_back(*it); }
+        };
+        if (route.empty()) {
+            if (from == to || local[0].seen[to] == stamp) { backTo(to); }
+            return cells;
+        }
+
+        backTo(cellOf[route[0]]);
+        for (size_t i = 1; i < route.size() && !full(); i++) {
+            int32_t u = route[i];
+            if (via[u] == NONE) {
+                cells.push_back(cellOf[u]);
+                continue;
+            }
+            const auto &segment = segments[via[u]];
+            for (size_t j = 1; j < segment.size() && !full(); j++) { cells.push_back(segment[j]); }
+        }
+        for (int32_t cell = cellOf[route.back()]; cell != to && !full();) {
+            cell = local[1].prev[cell];
+            cells.push_back(cell);
+        }
+        return cells;
+    }
+
+    // search + refine, empty if unreachable
+    vector<int32_t> path(int from, int to, int maxSteps = -1) {
+        if (search(from, to) < 0) { return {}; }
+        return refine(from, to, maxSteps);
+    }
+
+    void report() const {
+        cerr << "hpa clusters " << clusterNodes.size() << " size " << clusterSize << " nodes " << nodes()
+             << " segments " << segments.size() << " bytes " << bytes() << endl;
+    }
+
+  private:
+    vector<int32_t> queue0;
+    vector<int32_t> queue1;
+};
+
+// `map` repeated tileRows x tileCols times, seam walls are opened where open cells face each other across them
+template <typename M> M tileMap(const M &map, int tileRows, int tileCols) {
+    M big("");
+    big.rows = map.rows * tileRows;
+    big.cols = map.cols * tileCols;
+    big.map.assign(big.rows, vector<int>(big.cols, 0));
+    for (int r = 0; r < big.rows; r++) {
+        for (int c = 0; c < big.cols; c++) { big.map[r][c] = map.map[r % map.rows][c % map.cols]; }
+    }
+    auto door = [&](int r1, int c1, int r2, int c2, int r3, int c3, int r4, int c4) {
+        if (big.isAccessible(r1, c1) && big.isAccessible(r4, c4)) {
+            big.map[r2][c2] = big.map[r3][c3] = big.map[r1][c1];
+        }
+    };
+    for (int t = 1; t < tileCols; t++) {
+        int c = t * map.cols;
+        for (int r = 0; r < big.rows; r++) { door(r, c - 2, r, c - 1, r, c, r, c + 1); }
+    }
+    for (int t = 1; t < tileRows; t++) {
+        int r = t * map.rows;
+        for (int c = 0; c < big.cols; c++) { door(r - 2, c, r - 1, c, r, c, r + 1, c); }
+    }
+    big.build();
+    return big;
+}
+
+/**
+ * hpa against plain bfs on `map` tiled up to scale, `queries` random pairs of open cells
+ * reports build time, per query latency of the abstract cost, of the first `prefix` steps and of the whole path,
+ * and how far the costs are above the exact distance
+ */
+template <typename M>
+void benchHpa(const M &map, int tileRows, int tileCols, int clusterSize, int queries, int prefix) {
+    auto timeUs = [](auto &&fn) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    M big = tileMap(map, tileRows, tileCols);
+    vector<int32_t> cells;
+    for (int index = 0; index < big.rows * big.cols; index++) {
+        if (big.adj.degree(index) > 0) { cells.push_back(index); }
+    }
+    cerr << "hpa map " << big.rows << "x" << big.cols << " open cells " << cells.size() << endl;
+
+    Hpa hpa;
+    double us = timeUs([&]() { hpa = Hpa(big, clusterSize); });
+    cerr << "hpa build us " << us << endl;
+    hpa.report();
+
+    std::mt19937 rng(42);
+    uniform_int_distribution<int> pick(0, cells.size() - 1);
+    vector<pair<int32_t, int32_t>> pairs(queries);
+    for (auto &[from, to] : pairs) { from = cells[pick(rng)], to = cells[pick(rng)]; }
+
+    vector<int32_t> costs(queries);
+    int expanded = 0;
+    us = timeUs([&]() {
+        for (int i = 0; i < queries; i++) {
+            costs[i] = hpa.search(pairs[i].first, pairs[i].second);
+            expanded += hpa.expanded;
+        }
+    });
+    cerr << "hpa cost us/query " << us / queries << " expanded/query " << (double)expanded / queries << endl;
+
+    size_t steps = 0;
+    us = timeUs([&]() {
+        for (auto [from, to] : pairs) { steps += hpa.path(from, to, prefix).size(); }
+    });
+    cerr << "hpa first " << prefix << " steps us/query " << us / queries << endl;
+
+    int invalid = 0;
+    vector<vector<int32_t>> paths(queries);
+    us = timeUs([&]() {
+        for (int i = 0; i < queries; i++) { paths[i] = hpa.path(pairs[i].first, pairs[i].second); }
+    });
+    cerr << "hpa full path us/query " << us / queries << endl;
+
+    // exact distances by bfs, also the flat-grid baseline
+    double worst = 1, total = 0;
+    int reachable = 0;
+    vector<int32_t> dis(big.rows * big.cols);
+    us = timeUs([&]() {
+        for (int i = 0; i < queries; i++) {
+            auto [from, to] = pairs[i];
+            std::fill(dis.begin(), dis.end(), -1);
+            vector<int32_t> q = {from};
+            dis[from] = 0;
+            for (size_t head = 0; head < q.size() && dis[to] == -1; head++) {
+                for (int32_t v : big.adj[q[head]]) {
+                    if (dis[v] == -1) { dis[v] = dis[q[head]] + 1, q.push_back(v); }
+                }
+            }
+            const auto &cellPath = paths[i];
+            bool ok = (dis[to] == -1) == (costs[i] == -1);
+            if (costs[i] != -1) {
+                ok = ok && (int)cellPath.size() == costs[i] + 1 && cellPath.front() == from && cellPath.back() == to;
+                for (size_t j = 1; ok && j < cellPath.size(); j++) {
+                    auto next = big.adj[cellPath[j - 1]];
+                    ok = std::find(next.begin(), next.end(), cellPath[j]) != next.end();
+                }
+            }
+            if (!ok) { invalid++; }
+            if (dis[to] > 0 && costs[i] > 0) {
+                double ratio = (double)costs[i] / dis[to];
+                worst = max(worst, ratio), total += ratio, reachable++;
+            }
+        }
+    });
+    cerr << "bfs us/query " << us / queries << " hpa invalid " << invalid << " cost/exact mean "
+         << (reachable ? total / reachable : 1) << " worst " << worst << endl;
+}
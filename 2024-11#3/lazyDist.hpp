@@ -0,0 +1,75 @@
+#pragma once
+
+#include "csr.hpp"
+#include "mapf.hpp"
+
+// distance oracle for maps whose full table does not fit: a bfs row is computed the first time its goal is queried
+// and the most recently used rows are kept up to a byte budget, copies share one cache
+struct LazyDistance {
+    static constexpr size_t DEFAULT_BYTES = (size_t)256 << 20; // when rows are forced without a budget
+
+    struct Cache {
+        std::mutex mtx;
+        std::list<int32_t> order; // goals, most recent first
+        unordered_map<int32_t, pair<std::list<int32_t>::iterator, vector<int32_t>>> rows;
+        int hits = 0;
+        int misses = 0;
+        int evictions = 0;
+    };
+
+    Csr adj;
+    size_t maxRows = 0;
+    std::shared_ptr<Cache> cache;
+
+    LazyDistance() = default;
+    LazyDistance(const Csr &adj, size_t budgetBytes)
+        : adj(adj), maxRows(max<size_t>(1, budgetBytes / max<size_t>(1, adj.nodes() * sizeof(int32_t)))),
+          cache(std::make_shared<Cache>()) {}
+
+    bool enabled() const { return cache != nullptr; }
+    size_t bytes() const { return maxRows * adj.nodes() * sizeof(int32_t); }
+
+    // -1 if unreachable
+    int get(int from, int to) const {
+        if (from == to) { return 0; }
+        std::lock_guard lock(cache->mtx);
+        auto &rows = cache->rows;
+        auto &order = cache->order;
+
+        // symmetric, either endpoint's row answers; A* keeps asking about the same goal
+        for (auto [row, other] : {pair<int, int>{to, from}, pair<int, int>{from, to}}) {
+            auto it = rows.find(row);
+            if (it == rows.end()) { continue; }
+            cache->hits++;
+            order.splice(order.begin(), order, it->second.first);
+            return it->second.second[other];
+        }
+
+        cache->misses++;
+        if (rows.size() >= maxRows) {
+            rows.erase(order.back());
+            order.pop_back();
+            cache->evictions++;
+        }
+        vector<int32_t> dis(adj.nodes(), -1);
+        vector<int32_t> q = {(int32_t)to};
+        dis[to] = 0;
+        for (size_t head = 0; head < q.size(); head++) {
+            int32_t u = q[head];
+            for (int32_t v : adj[u]) {
+                if (dis[v] != -1) { continue; }
+                dis[v] = dis[u] + 1;
+                q.push_back(v);
+            }
+        }
+        order.push_front(to);
+        auto &row = rows[to] = make_pair(order.begin(), std::move(dis));
+        return row.second[from];
+    }
+
+    void report() const {
+        std::lock_guard lock(cache->mtx);
+        cerr << "lazy distance rows " << cache->rows.size() << "/" << maxRows << " hits " << cache->hits << " misses "
+             << cache->misses << " evictions " << cache->evictions << " bytes " << bytes() << endl;
+    }
+};
@@ -1,19 +1,40 @@
+#pragma once
+
 #include <algorithm>
+#include <atomic>
+#include <bit>
 #include <chrono>
+#include <cstdint>
+#include <cstdio>
 #include <fstream>
 #include <functional>
 #include <iostream>
+#include <list>
+#include <memory>
+#include <mutex>
 #include <queue>
 #include <random>
 #include <ranges>
 #include <set>
+#include <span>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include <vector>
 
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 
 // defines
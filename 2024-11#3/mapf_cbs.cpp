@@ -1,8 +1,22 @@
+#include "../common/distCache.hpp"
+
+#include "alt.hpp"
+#include "apsp.hpp"
+#include "csr.hpp"
+#include "hpa.hpp"
+#include "lazyDist.hpp"
 #include "mapf.hpp"
 
 // constants
 
 const int INF = 1e18;
+const int DIST_BUDGET = 0; // bytes for the distance table, 0 -> unlimited
+const int APSP_THREADS = 0; // 0 -> hardware_concurrency
+const ApspBackend APSP_BACKEND = ApspBackend::Queue;
+const int LANDMARKS = 0; // alt landmarks for the aStar heuristic, 0 -> exact distances
+const bool BENCH_APSP = false;
+const bool BENCH_HPA = false; // hpa against bfs on the map tiled 4x5
+const bool BENCH_ALT = false; // A* expansions per heuristic on the map tiled 4x5
 const int dr[] = {0, 1, 0, -1};
 const int dc[] = {1, 0, -1, 0};
 
@@ -66,6 +80,7 @@ struct Map {
     int cols = 0;
     int rows = 0;
     matrix<int> map;
+    Csr adj; // 4-neighbour adjacency between accessible cells, by index
 
     Map(string_view dir) : dir(dir) {}
 
@@ -91,6 +106,19 @@ struct Map {
         } while (getline(fin, line));
 
         fin.close();
+
+        build();
+    }
+
+    // rebuild adj from `map`, rows and cols
+    void build() {
+        adj.build(rows * cols, [&](int index, auto emit) {
+            auto [r, c] = toCoord(index);
+            if (!isAccessible(r, c)) { return; }
+            for (int i = 0; i < 4; i++) {
+                if (isAccessible(r + dr[i], c + dc[i])) { emit(toIndex(r + dr[i], c + dc[i])); }
+            }
+        });
     }
 
     bool isAccessible(int r, int c) const {
@@ -136,43 +164,79 @@ struct Task {
 };
 
 struct FloydMap {
+    static constexpr uint16_t UNREACHABLE = 0xffff;
+
     int rows = 0;
     int cols = 0;
     int size = 0;
-    matrix<int> floyd;
+    SlotMap slots;            // accessible cells only
+    uint16_t *table = nullptr; // slots * slots, row-major
+    std::shared_ptr<void> storage;
+    LazyDistance lazy; // used instead of the table when it does not fit the budget
+    Landmarks alt;     // heuristic() bounds, when built
 
     int toIndex(int r, int c) const { return r * cols + c; }
     pii toCoord(int index) const { return {index / cols, index % cols}; }
 
-    FloydMap(const Map &map) {
+    // reuse the table in `cacheFile` when it matches the map, otherwise build it and write the cache
+    // a table larger than `budgetBytes` (0 = unlimited) is not built, rows are computed on demand instead
+    // `landmarks` > 0 makes heuristic() answer from that many alt rows instead of exact distances and skips the table,
+    // distance() then comes from lazy rows
+    FloydMap(const Map &map, string cacheFile = "", size_t budgetBytes = 0, int threads = 0,
+             ApspBackend backend = ApspBackend::Queue, int landmarks = 0) {
         rows = map.rows;
         cols = map.cols;
         size = rows * cols;
-        matrixResize(floyd, size, size, INF);
-
-        // init
-        for (int i = 0; i < size; i++) {
-            auto [r, c] = toCoord(i);
-            bool isAccessible = map.isAccessible(r, c);
-            floyd[i][i] = (isAccessible ? 0 : INF);
-            if (!isAccessible) { continue; }
-            for (int j = 0; j < 4; j++) {
-                int nr = r + dr[j];
-                int nc = c + dc[j];
-                if (map.isAccessible(nr, nc)) { floyd[i][toIndex(nr, nc)] = 1; }
-            }
+        slots = SlotMap(map);
+        if (landmarks > 0) { alt = Landmarks(map, landmarks); }
+        size_t entries = (size_t)slots.size() * slots.size();
+
+        // uint16 entries would wrap past UNREACHABLE - 1 steps, rows are computed on demand then as well
+        if (landmarks > 0 || (budgetBytes > 0 && entries * sizeof(uint16_t) > budgetBytes) ||
+            slots.size() >= UNREACHABLE) {
+            lazy = LazyDistance(map.adj, budgetBytes > 0 ? budgetBytes : LazyDistance::DEFAULT_BYTES);
+            return;
         }
 
-        // floyd
-        for (int k = 0; k < size; k++) {
-            for (int i = 0; i < size; i++) {
-                for (int j = 0; j < size; j++) { floyd[i][j] = min(floyd[i][j], floyd[i][k] + floyd[k][j]); }
-            }
+        DistCacheHeader header;
+        header.hash = gridHash(map.map);
+        header.rows = rows;
+        header.cols = cols;
+        header.entrySize = sizeof(uint16_t);
+        header.entries = entries;
+        if (!cacheFile.empty()) {
+            table = static_cast<uint16_t *>(loadDistCache(cacheFile, header, storage));
+            if (table != nullptr) { return; }
+        }
+
+        std::shared_ptr<uint16_t[]> buffer(new uint16_t[max<size_t>(1, entries)]);
+        storage = buffer;
+        table = buffer.get();
+        if (backend == ApspBackend::Bitboard) {
+            bitBfsApsp(map, slots, table, UNREACHABLE, threads);
+        } else {
+            bfsApsp(map.adj, slots, table, UNREACHABLE, threads);
         }
+        if (!cacheFile.empty() && !saveDistCache(cacheFile, header, table)) { DEBUG("Cache file not written"); }
     }
 
     int distance(int fromR, int fromC, int toR, int toC) const {
-        return floyd[toIndex(fromR, fromC)][toIndex(toR, toC)];
+        if (lazy.enabled()) {
+            int d = lazy.get(toIndex(fromR, fromC), toIndex(toR, toC));
+            return d < 0 ? INF : d;
+        }
+        int32_t from = slots.slotOf[toIndex(fromR, fromC)];
+        int32_t to = slots.slotOf[toIndex(toR, toC)];
+        if (from < 0 || to < 0) { return INF; }
+        uint16_t d = table[from * slots.size() + to];
+        return d == UNREACHABLE ? INF : d;
+    }
+
+    // lower bound for A*, exact unless landmarks were asked for
+    int heuristic(int fromR, int fromC, int toR, int toC) const {
+        if (!alt.enabled()) { return distance(fromR, fromC, toR, toC); }
+        int d = alt.bound(toIndex(fromR, fromC), toIndex(toR, toC));
+        return d < 0 ? INF : d;
     }
 };
 
@@ -363,7 +427,7 @@ vector<pii> aStar(const Map &map, const FloydMap &floyd, int fromR, int fromC, i
     vector<int> vis(floyd.size, false);
     vector<int> prev(floyd.size, -1);
 
-    heap.push(AStarNode(fromR, fromC, 0, floyd.distance(fromR, fromC, toR, toC)));
+    heap.push(AStarNode(fromR, fromC, 0, floyd.heuristic(fromR, fromC, toR, toC)));
 
     while (!heap.empty()) {
         auto cur = heap.top();
@@ -380,19 +444,16 @@ vector<pii> aStar(const Map &map, const FloydMap &floyd, int fromR, int fromC, i
         if (vis[index]) { continue; }
         // vis[index] = true;
 
-        for (int i = 0; i < 4; i++) {
-            int nr = cur.r + dr[i];
-            int nc = cur.c + dc[i];
+        for (int nindex : map.adj[index]) {
+            auto [nr, nc] = map.toCoord(nindex);
             int ntime = cur.dis + 1;
 
             if (violateConstraint(nr, nc, ntime, id, constraints)) { continue; }
-            if (vis[map.toIndex(nr, nc)]) { continue; }
+            if (vis[nindex]) { continue; }
 
-            if (map.isAccessible(nr, nc)) {
-                int h = floyd.distance(nr, nc, toR, toC);
-                heap.push(AStarNode(nr, nc, cur.dis + 1, h));
-                prev[map.toIndex(nr, nc)] = index;
-            }
+            int h = floyd.heuristic(nr, nc, toR, toC);
+            heap.push(AStarNode(nr, nc, cur.dis + 1, h));
+            prev[nindex] = index;
         }
     }
 
@@ -455,10 +516,8 @@ matrix<pii> cbs(const Map &map, const FloydMap &floyd, const Task &task) {
                     int index = q.front();
                     q.pop();
                     auto [r, c] = map.toCoord(index);
-                    for (int j = 0; j < 4; j++) {
-                        int nr = r + dr[j];
-                        int nc = c + dc[j];
-                        if (!map.isAccessible(nr, nc)) { continue; }
+                    for (int nindex : map.adj[index]) {
+                        auto [nr, nc] = map.toCoord(nindex);
                         if (map.isNarrow(nr, nc) && !viss(nr, nc)) {
                             q.push(map.toIndex(nr, nc));
                             vis.push_back(map.toIndex(nr, nc));
@@ -504,9 +563,27 @@ signed main() {
     }
 
 
+    if (BENCH_APSP) {
+        benchApsp<FloydMap>(map, INF);
+        return 0;
+    }
+    if (BENCH_HPA) {
+        benchHpa(map, 4, 5, 10, 10000, 16);
+        return 0;
+    }
+    if (BENCH_ALT) {
+        benchAlt(tileMap(map, 4, 5), 2000, 32);
+        return 0;
+    }
+
     // test
+    Clock buildClock;
+    buildClock.start();
+    FloydMap floyd(map, "map.dist", DIST_BUDGET, APSP_THREADS, APSP_BACKEND, LANDMARKS);
+    buildClock.stop();
+    DEBUG(buildClock.durationMus());
+
     Clock floydClock;
-    FloydMap floyd(map);
 
     floydClock.start();
     int floydDistance = evaluateFloyd(floyd, task);
@@ -522,6 +599,10 @@ signed main() {
 
     DEBUG(totalCost(paths));
     DEBUG(CbsClock.durationMus());
+    if (floyd.lazy.enabled()) { floyd.lazy.report(); }
+    if (floyd.alt.enabled()) {
+        cerr << "alt landmarks " << floyd.alt.count() << " bytes " << floyd.alt.bytes() << endl;
+    }
 
 
 
@@ -1,3 +1,10 @@
+#include "../common/distCache.hpp"
+
+#include "alt.hpp"
+#include "apsp.hpp"
+#include "csr.hpp"
+#include "hpa.hpp"
+#include "lazyDist.hpp"
 #include "mapf.hpp"
 
 // constants
@@ -10,6 +17,13 @@ const unordered_map<char, int> mapMap = {{'#', 0}, {'$', 1}, {'o', 2}, {'P', 3}}
 
 const int AGV_SIZE = 10;
 const int TASK_SIZE = 20;
+const int DIST_BUDGET = 0; // bytes for the distance table, 0 -> unlimited
+const int APSP_THREADS = 0; // 0 -> hardware_concurrency
+const ApspBackend APSP_BACKEND = ApspBackend::Queue;
+const int LANDMARKS = 0; // alt landmarks for the aStar heuristic, 0 -> exact distances
+const bool BENCH_APSP = false;
+const bool BENCH_HPA = false; // hpa against bfs on the map tiled 4x5
+const bool BENCH_ALT = false; // A* expansions per heuristic on the map tiled 4x5
 
 // globals
 
@@ -69,6 +83,7 @@ struct Map {
     int cols = 0;
     int rows = 0;
     matrix<int> map;
+    Csr adj; // 4-neighbour adjacency between accessible cells, by index
 
     Map(string_view dir) : dir(dir) {}
 
@@ -94,6 +109,19 @@ struct Map {
         } while (getline(fin, line));
 
         fin.close();
+
+        build();
+    }
+
+    // rebuild adj from `map`, rows and cols
+    void build() {
+        adj.build(rows * cols, [&](int index, auto emit) {
+            auto [r, c] = toCoord(index);
+            if (!isAccessible(r, c)) { return; }
+            for (int i = 0; i < 4; i++) {
+                if (isAccessible(r + dr[i], c + dc[i])) { emit(toIndex(r + dr[i], c + dc[i])); }
+            }
+        });
     }
 
     bool isAccessible(int r, int c) const {
@@ -137,43 +165,79 @@ struct Task {
 };
 
 struct FloydMap {
+    static constexpr uint16_t UNREACHABLE = 0xffff;
+
     int rows = 0;
     int cols = 0;
     int size = 0;
-    matrix<int> floyd;
+    SlotMap slots;            // accessible cells only
+    uint16_t *table = nullptr; // slots * slots, row-major
+    std::shared_ptr<void> storage;
+    LazyDistance lazy; // used instead of the table when it does not fit the budget
+    Landmarks alt;     // heuristic() bounds, when built
 
     int toIndex(int r, int c) const { return r * cols + c; }
     pii toCoord(int index) const { return {index / cols, index % cols}; }
 
-    FloydMap(const Map &map) {
+    // reuse the table in `cacheFile` when it matches the map, otherwise build it and write the cache
+    // a table larger than `budgetBytes` (0 = unlimited) is not built, rows are computed on demand instead
+    // `landmarks` > 0 makes heuristic() answer from that many alt rows instead of exact distances and skips the table,
+    // distance() then comes from lazy rows
+    FloydMap(const Map &map, string cacheFile = "", size_t budgetBytes = 0, int threads = 0,
+             ApspBackend backend = ApspBackend::Queue, int landmarks = 0) {
         rows = map.rows;
         cols = map.cols;
         size = rows * cols;
-        matrixResize(floyd, size, size, INF);
-
-        // init
-        for (int i = 0; i < size; i++) {
-            auto [r, c] = toCoord(i);
-            bool isAccessible = map.isAccessible(r, c);
-            floyd[i][i] = (isAccessible ? 0 : INF);
-            if (!isAccessible) { continue; }
-            for (int j = 0; j < 4; j++) {
-                int nr = r + dr[j];
-                int nc = c + dc[j];
-                if (map.isAccessible(nr, nc)) { floyd[i][toIndex(nr, nc)] = 1; }
-            }
+        slots = SlotMap(map);
+        if (landmarks > 0) { alt = Landmarks(map, landmarks); }
+        size_t entries = (size_t)slots.size() * slots.size();
+
+        // uint16 entries would wrap past UNREACHABLE - 1 steps, rows are computed on demand then as well
+        if (landmarks > 0 || (budgetBytes > 0 && entries * sizeof(uint16_t) > budgetBytes) ||
+            slots.size() >= UNREACHABLE) {
+            lazy = LazyDistance(map.adj, budgetBytes > 0 ? budgetBytes : LazyDistance::DEFAULT_BYTES);
+            return;
         }
 
-        // floyd
-        for (int k = 0; k < size; k++) {
-            for (int i = 0; i < size; i++) {
-                for (int j = 0; j < size; j++) { floyd[i][j] = min(floyd[i][j], floyd[i][k] + floyd[k][j]); }
-            }
+        DistCacheHeader header;
+        header.hash = gridHash(map.map);
+        header.rows = rows;
+        header.cols = cols;
+        header.entrySize = sizeof(uint16_t);
+        header.entries = entries;
+        if (!cacheFile.empty()) {
+            table = static_cast<uint16_t *>(loadDistCache(cacheFile, header, storage));
+            if (table != nullptr) { return; }
+        }
+
+        std::shared_ptr<uint16_t[]> buffer(new uint16_t[max<size_t>(1, entries)]);
+        storage = buffer;
+        table = buffer.get();
+        if (backend == ApspBackend::Bitboard) {
+            bitBfsApsp(map, slots, table, UNREACHABLE, threads);
+        } else {
+            bfsApsp(map.adj, slots, table, UNREACHABLE, threads);
         }
+        if (!cacheFile.empty() && !saveDistCache(cacheFile, header, table)) { DEBUG("Cache file not written"); }
     }
 
     int distance(int fromR, int fromC, int toR, int toC) const {
-        return floyd[toIndex(fromR, fromC)][toIndex(toR, toC)];
+        if (lazy.enabled()) {
+            int d = lazy.get(toIndex(fromR, fromC), toIndex(toR, toC));
+            return d < 0 ? INF : d;
+        }
+        int32_t from = slots.slotOf[toIndex(fromR, fromC)];
+        int32_t to = slots.slotOf[toIndex(toR, toC)];
+        if (from < 0 || to < 0) { return INF; }
+        uint16_t d = table[from * slots.size() + to];
+        return d == UNREACHABLE ? INF : d;
+    }
+
+    // lower bound for A*, exact unless landmarks were asked for
+    int heuristic(int fromR, int fromC, int toR, int toC) const {
+        if (!alt.enabled()) { return distance(fromR, fromC, toR, toC); }
+        int d = alt.bound(toIndex(fromR, fromC), toIndex(toR, toC));
+        return d < 0 ? INF : d;
     }
 };
 
@@ -282,7 +346,7 @@ vector<int> aStar(const Map &map, const FloydMap &floyd, AStarMap &aStarMap, int
     auto dist = [&](int from, int to) {
         auto [r1, c1] = map.toCoord(from);
         auto [r2, c2] = map.toCoord(to);
-        return floyd.distance(r1, c1, r2, c2);
+        return floyd.heuristic(r1, c1, r2, c2);
     };
 
     heap.emplace(fromIndex, startTime, dist(fromIndex, toIndex));
@@ -290,7 +354,6 @@ vector<int> aStar(const Map &map, const FloydMap &floyd, AStarMap &aStarMap, int
     while (!heap.empty()) {
         auto cur = heap.top();
         int index = cur.index;
-        auto [r, c] = map.toCoord(index);
         heap.pop();
 
         if (vis[index]) { continue; }
@@ -306,14 +369,10 @@ vector<int> aStar(const Map &map, const FloydMap &floyd, AStarMap &aStarMap, int
             return path;
         }
 
-        for (int i = 0; i < 4; i++) {
-            int nr = r + dr[i];
-            int nc = c + dc[i];
+        for (int nindex : map.adj[index]) {
             int ntime = cur.dis + 1;
-            int nindex = map.toIndex(nr, nc);
 
             if (vis[nindex]) { continue; }
-            if (!map.isAccessible(nr, nc)) { continue; }
             if (aStarMap.isLocked(nindex, ntime)) { continue; }
 
             int h = dist(nindex, toIndex);
@@ -377,9 +436,27 @@ signed main() {
     }
 
 
+    if (BENCH_APSP) {
+        benchApsp<FloydMap>(map, INF);
+        return 0;
+    }
+    if (BENCH_HPA) {
+        benchHpa(map, 4, 5, 10, 10000, 16);
+        return 0;
+    }
+    if (BENCH_ALT) {
+        benchAlt(tileMap(map, 4, 5), 2000, 32);
+        return 0;
+    }
+
     // test
+    Clock buildClock;
+    buildClock.start();
+    FloydMap floyd(map, "map.dist", DIST_BUDGET, APSP_THREADS, APSP_BACKEND, LANDMARKS);
+    buildClock.stop();
+    DEBUG(buildClock.durationMus());
+
     Clock floydClock;
-    FloydMap floyd(map);
 
     floydClock.start();
     int floydDistance = evaluateFloyd(floyd, task);
@@ -400,6 +477,10 @@ signed main() {
     DEBUG(totalCost(paths));
     // DEBUG(maxCost(paths));
     DEBUG(aStarClock.durationMus());
+    if (floyd.lazy.enabled()) { floyd.lazy.report(); }
+    if (floyd.alt.enabled()) {
+        cerr << "alt landmarks " << floyd.alt.count() << " bytes " << floyd.alt.bytes() << endl;
+    }
 
 
 
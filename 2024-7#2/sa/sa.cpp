@@ -4,6 +4,8 @@
 #include <string>
 #include <vector>
 
+#include "../../common/distCache.hpp"
+
 using namespace std;
 
 #define DEBUG(X) \
@@ -16,6 +18,7 @@ typedef pair<int, int> pii;
 
 const string mapFile = "map.txt";
 const string orderFile = "order.txt";
+const string cacheFile = "map.dist";
 const int INT_SOFT_MAX = 1e9 + 7;
 const int dc[] = {0, 1, 0, -1};
 const int dr[] = {-1, 0, 1, 0};
@@ -34,7 +37,15 @@ int toNode(const matrix<char> &map, int r, int c) {
     return r * map[0].size() + c;
 }
 
-double dp(const matrix<char> &map, const matrix<int> &floyd, const vector<pii> &order, const vector<int> &schedule) {
+// floyd table in one flat buffer, so it can be mapped from the distance cache; indexed floyd[u][v] as a matrix
+struct FloydTable {
+    int *data = nullptr;
+    int nodes = 0;
+
+    int *operator[](int u) const { return data + (size_t)u * nodes; }
+};
+
+double dp(const matrix<char> &map, const FloydTable &floyd, const vector<pii> &order, const vector<int> &schedule) {
     auto to_node = [=](int r, int c) { return toNode(map, r, c); };
     auto dis = [=](int fromR, int fromC, int toR, int toC) { return floyd[to_node(fromR, fromC)][to_node(toR, toC)]; };
     auto cost = [=](int from, int to) {
@@ -89,6 +100,39 @@ double dp(const matrix<char> &map, const matrix<int> &floyd, const vector<pii> &
     return ret;
 }
 
+// all pairs between 'o' cells, floydMap comes in filled with INT_SOFT_MAX
+void solveFloyd(const matrix<char> &inputMap, const FloydTable &floydMap) {
+    int rows = inputMap.size();
+    int cols = inputMap[0].size();
+    int nodes = rows * cols;
+
+    auto to_node = [=](int r, int c) { return toNode(inputMap, r, c); };
+
+    for (int i = 0; i < nodes; i++) { floydMap[i][i] = 0; }
+    for (int r = 0; r < rows; r++) {
+        for (int c = 0; c < cols; c++) {
+            if (inputMap[r][c] != 'o') continue;
+            int u = to_node(r, c);
+            for (int i = 0; i < 4; i++) {
+                int tr = r + dr[i];
+                int tc = c + dc[i];
+                if (tr < 0 || tr >= rows || tc < 0 || tc >= cols) continue;
+                if (inputMap[tr][tc] != 'o') continue;
+                int v = to_node(tr, tc);
+                floydMap[u][v] = 1;
+            }
+        }
+    }
+    // floyd
+    for (int k = 0; k < nodes; k++) {
+        for (int i = 0; i < nodes; i++) {
+            for (int j = 0; j < nodes; j++) {
+                floydMap[i][j] = min(floydMap[i][j], floydMap[i][k] + floydMap[k][j]);
+            }
+        }
+    }
+}
+
 int main() {
 
     // variables
@@ -122,32 +166,21 @@ int main() {
     int rows = inputMap.size();
     int cols = inputMap[0].size();
     int nodes = rows * cols;
-    matrix<int> floydMap(nodes, vector<int>(nodes, INT_SOFT_MAX));
-
-    auto to_node = [=](int r, int c) { return toNode(inputMap, r, c); };
-
-    for (int i = 0; i < nodes; i++) { floydMap[i][i] = 0; }
-    for (int r = 0; r < rows; r++) {
-        for (int c = 0; c < cols; c++) {
-            if (inputMap[r][c] != 'o') continue;
-            int u = to_node(r, c);
-            for (int i = 0; i < 4; i++) {
-                int tr = r + dr[i];
-                int tc = c + dc[i];
-                if (tr < 0 || tr >= rows || tc < 0 || tc >= cols) continue;
-                if (inputMap[tr][tc] != 'o') continue;
-                int v = to_node(tr, tc);
-                floydMap[u][v] = 1;
-            }
-        }
-    }
-    // floyd
-    for (int k = 0; k < nodes; k++) {
-        for (int i = 0; i < nodes; i++) {
-            for (int j = 0; j < nodes; j++) {
-                floydMap[i][j] = min(floydMap[i][j], floydMap[i][k] + floydMap[k][j]);
-            }
-        }
+    DistCacheHeader header;
+    header.hash = gridHash(inputMap);
+    header.rows = rows;
+    header.cols = cols;
+    header.entrySize = sizeof(int);
+    header.entries = (uint64_t)nodes * nodes;
+    shared_ptr<void> floydStorage;
+    FloydTable floydMap{(int *)loadDistCache(cacheFile, header, floydStorage), nodes};
+    if (floydMap.data == nullptr) {
+        shared_ptr<int[]> buffer(new int[header.entries]);
+        fill(buffer.get(), buffer.get() + header.entries, INT_SOFT_MAX);
+        floydStorage = buffer;
+        floydMap.data = buffer.get();
+        solveFloyd(inputMap, floydMap);
+        if (!saveDistCache(cacheFile, header, floydMap.data)) DEBUG("cache write failed");
     }
 
     DEBUG("floyd done");
@@ -0,0 +1,83 @@
+#include "assignment.hpp"
+
+void Assignment::init(int cols) {
+    this->cols = cols;
+    cost.clear();
+    u.assign(1, 0);
+    v.assign(cols + 1, 0);
+    colRow.assign(cols + 1, 0);
+}
+
+void Assignment::addRow(ref<vector<int>> row) {
+    const int64_t INF = INT64_MAX / 4;
+    cost.push_back(row);
+    u.push_back(0);
+    val i = rows();
+    // dijkstra over reduced costs from the new row until it reaches a free column, then flip the path
+    vector<int64_t> minv(cols + 1, INF);
+    vector<int> way(cols + 1, 0);
+    vector<char> used(cols + 1, 0);
+    colRow[0] = i;
+    var j0 = 0;
+    do {
+        used[j0] = 1;
+        val i0 = colRow[j0];
+        var delta = INF;
+        var j1 = 0;
+        for (var j = 1; j <= cols; j++) {
+            if (used[j]) continue;
+            val cur = cost[i0 - 1][j - 1] - u[i0] - v[j];
+            if (cur < minv[j]) {
+                minv[j] = cur;
+                way[j] = j0;
+            }
+            if (minv[j] < delta) {
+                delta = minv[j];
+                j1 = j;
+            }
+        }
+        for (var j = 0; j <= cols; j++) {
+            if (used[j]) {
+                u[colRow[j]] += delta;
+                v[j] -= delta;
+            } else {
+                minv[j] -= delta;
+            }
+        }
+        j0 = j1;
+    } while (colRow[j0] != 0);
+    do {
+        val j1 = way[j0];
+        colRow[j0] = colRow[j1];
+        j0 = j1;
+    } while (j0 != 0);
+}
+
+vector<int> Assignment::rowCol() const {
+    vector<int> ret(rows(), -1);
+    for (var j = 1; j <= cols; j++) {
+        if (colRow[j] != 0) ret[colRow[j] - 1] = j - 1;
+    }
+    return ret;
+}
+
+vector<int> solveAssignment(ref<matrix<int>> cost, int cols) {
+    val rows = (int)cost.size();
+    Assignment a;
+    if (rows <= cols) {
+        a.init(cols);
+        for (val &row : cost) a.addRow(row);
+        return a.rowCol();
+    }
+    // more rows than columns, match the columns instead
+    a.init(rows);
+    for (var j = 0; j < cols; j++) {
+        vector<int> col(rows);
+        for (var i = 0; i < rows; i++) col[i] = cost[i][j];
+        a.addRow(col);
+    }
+    vector<int> ret(rows, -1);
+    val colOf = a.rowCol();
+    for (var j = 0; j < cols; j++) ret[colOf[j]] = j;
+    return ret;
+}
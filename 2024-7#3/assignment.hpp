@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+
+#include "top.hpp"
+
+// min-cost matching of every row to a distinct column, hungarian method by shortest augmenting paths
+// rows are added one at a time, each one augments the optimal matching of the rows before it in O(rows * cols)
+// the potentials only hold for the costs they were built on, a row whose costs change needs a new Assignment
+struct Assignment {
+    int cols = 0;
+    matrix<int> cost;     // rows added so far
+    vector<int64_t> u, v; // row and column potentials, 1-based with a dummy 0
+    vector<int> colRow;   // 1-based row matched to each 1-based column, 0 if none
+    //
+    void init(int cols);
+    int rows() const { return cost.size(); }
+    void addRow(ref<vector<int>> row); // needs rows() < cols
+    vector<int> rowCol() const;        // column of each row
+};
+
+// column of each row minimising the total, -1 for rows left over when there are more rows than columns
+vector<int> solveAssignment(ref<matrix<int>> cost, int cols);
@@ -0,0 +1,48 @@
+// intrinsics first, they must not see the var/val macros from top.hpp
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#include "bitBfs.hpp"
+
+void BitGrid::init(ref<matrix<char>> grid, char freeCell) {
+    rows = grid.size();
+    cols = rows ? grid[0].size() : 0;
+    stride = (cols + 63) / 64 + 2;
+    free.assign((size_t)(rows + 2) * stride, 0);
+    for (var r = 0; r < rows; r++) {
+        for (var c = 0; c < min(cols, (int)grid[r].size()); c++) {
+            if (grid[r][c] == freeCell) free[word(r, c)] |= 1ULL << (c % 64);
+        }
+    }
+}
+
+bool bitExpand(const uint64_t *front, const uint64_t *free, const uint64_t *seen, uint64_t *next, size_t begin,
+               size_t end, int stride) {
+    var i = begin;
+    uint64_t any = 0;
+#ifdef __AVX2__
+    var anyV = _mm256_setzero_si256();
+    for (; i + 4 <= end; i += 4) {
+        fun load = [&](size_t at) { return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(front + at)); };
+        val f = load(i);
+        val left = _mm256_or_si256(_mm256_slli_epi64(f, 1), _mm256_srli_epi64(load(i - 1), 63));
+        val right = _mm256_or_si256(_mm256_srli_epi64(f, 1), _mm256_slli_epi64(load(i + 1), 63));
+        val vertical = _mm256_or_si256(load(i - stride), load(i + stride));
+        var reach = _mm256_or_si256(_mm256_or_si256(f, left), _mm256_or_si256(right, vertical));
+        reach = _mm256_and_si256(reach, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(free + i)));
+        reach = _mm256_andnot_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(seen + i)), reach);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(next + i), reach);
+        anyV = _mm256_or_si256(anyV, reach);
+    }
+    any = !_mm256_testz_si256(anyV, anyV);
+#endif
+    for (; i < end; i++) {
+        val f = front[i];
+        val reach = f | (f << 1) | (front[i - 1] >> 63) | (f >> 1) | (front[i + 1] << 63) | front[i - stride] |
+                    front[i + stride];
+        next[i] = reach & free[i] & ~seen[i];
+        any |= next[i];
+    }
+    return any != 0;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+
+#include "top.hpp"
+
+// grid bfs on bit rows: the free mask and the wavefront are 64-bit words, one layer is a handful of shift/and/or
+// passes over rows * words instead of a queue; rows are padded by a zero word on every side so the kernel is
+// branch-free (and AVX2 wide when compiled with -mavx2)
+struct BitGrid {
+    int rows = 0, cols = 0;
+    int stride = 0; // words per padded row
+    vector<uint64_t> free;
+    //
+    struct Scratch {
+        vector<uint64_t> front, next, seen;
+    };
+    //
+    void init(ref<matrix<char>> grid, char freeCell);
+    size_t word(int r, int c) const { return (size_t)(r + 1) * stride + 1 + c / 64; }
+    bool isFree(int r, int c) const { return free[word(r, c)] >> (c % 64) & 1; }
+    // calls visit(r, c, d) for every cell reachable from (r, c), layer by layer
+    template <typename F> void bfs(int r, int c, Scratch &s, F &&visit) const;
+};
+
+// next = (front | 4 neighbours of front) & free & ~seen over words [begin, end), returns whether next is non-empty
+bool bitExpand(const uint64_t *front, const uint64_t *free, const uint64_t *seen, uint64_t *next, size_t begin,
+               size_t end, int stride);
+
+template <typename F> void BitGrid::bfs(int r, int c, Scratch &s, F &&visit) const {
+    val size = free.size();
+    s.front.assign(size, 0);
+    s.next.assign(size, 0);
+    s.seen.assign(size, 0);
+    if (!isFree(r, c)) return;
+    s.front[word(r, c)] = s.seen[word(r, c)] = 1ULL << (c % 64);
+    visit(r, c, 0);
+    // only the interior rows can change, the padding stays zero
+    val begin = (size_t)stride, end = size - stride;
+    for (var d = 1; bitExpand(s.front.data(), free.data(), s.seen.data(), s.next.data(), begin, end, stride); d++) {
+        for (var i = begin; i < end; i++) {
+            var bits = s.next[i];
+            s.seen[i] |= bits;
+            while (bits) {
+                val b = std::countr_zero(bits);
+                bits &= bits - 1;
+                val row = (int)(i / stride) - 1;
+                val col = (int)(i % stride - 1) * 64 + b;
+                visit(row, col, d);
+            }
+        }
+        std::swap(s.front, s.next);
+    }
+}
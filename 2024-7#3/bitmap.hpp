@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+
+#include "top.hpp"
+
+// fixed-size bit set, used for cell occupancy and per-agv state flags
+struct Bitmap {
+    vector<uint64_t> words;
+    //
+    void init(int n) { words.assign((n + 63) / 64, 0); }
+    void clear() { std::fill(words.begin(), words.end(), 0); }
+    void set(int i) { words[i >> 6] |= 1ULL << (i & 63); }
+    void reset(int i) { words[i >> 6] &= ~(1ULL << (i & 63)); }
+    void assign(int i, bool v) { v ? set(i) : reset(i); }
+    bool test(int i) const { return words[i >> 6] >> (i & 63) & 1; }
+    bool none() const {
+        return std::all_of(words.begin(), words.end(), [](uint64_t w) { return w == 0; });
+    }
+    // smallest set index i with pred(i), -1 if none
+    template <typename F> int findFirst(F &&pred) const {
+        for (var w = 0; w < (int)words.size(); w++) {
+            for (var bits = words[w]; bits; bits &= bits - 1) {
+                val i = w * 64 + std::countr_zero(bits);
+                if (pred(i)) return i;
+            }
+        }
+        return -1;
+    }
+};
@@ -0,0 +1,184 @@
+#include "config.hpp"
+
+#include "reservation.hpp"
+
+bool Config::parse(int argc, char **argv) {
+    for (var i = 1; i < argc; i++) {
+        val arg = string(argv[i]);
+        fun next = [&]() -> string {
+            if (i + 1 >= argc) {
+                cerr << "missing value for " << arg << endl;
+                return "";
+            }
+            if (argv[i + 1][0] == '\0') cerr << "empty value for " << arg << endl;
+            return argv[++i];
+        };
+        // the whole value has to parse, stoi and stod alone would take "4x" as 4 and throw on "x"
+        fun parsed = [&](ref<string> v, auto parse) {
+            size_t used = 0;
+            try {
+                parse(v, &used);
+            } catch (const std::exception &) {
+                used = 0;
+            }
+            val ok = used != 0 && used == v.size();
+            if (!ok && !v.empty()) cerr << "bad value for " << arg << ": " << v << endl;
+            return ok;
+        };
+        fun integer = [&](ref<string> v, int &out) {
+            return parsed(v, [&](ref<string> s, size_t *used) { out = std::stoi(s, used); });
+        };
+        fun number = [&](int &out) { return integer(next(), out); };
+        fun atLeast = [&](int &out, int low) {
+            if (!number(out)) return false;
+            if (out < low) cerr << arg << " must be at least " << low << endl;
+            return out >= low;
+        };
+        fun real = [&](double &out, double low) {
+            if (!parsed(next(), [&](ref<string> v, size_t *used) { out = std::stod(v, used); })) return false;
+            if (out < low) cerr << arg << " must be at least " << low << endl;
+            return out >= low;
+        };
+        fun numbers = [&](vector<int> &out) {
+            val v = next();
+            out.clear();
+            for (size_t from = 0; from <= v.size() && !v.empty();) {
+                val to = min(v.find(',', from), v.size());
+                var n = 0;
+                if (!integer(v.substr(from, to - from), n)) {
+                    if (to == from) cerr << "bad value for " << arg << ": " << v << endl;
+                    return false;
+                }
+                out.push_back(n);
+                from = to + 1;
+            }
+            return !out.empty();
+        };
+        // a file name, an empty one would read or write nothing
+        fun file = [&](string &out) {
+            out = next();
+            return !out.empty();
+        };
+        fun allAtLeast = [&](vector<int> &out, int low) {
+            if (!numbers(out)) return false;
+            val ok = std::all_of(out.begin(), out.end(), [&](int v) { return v >= low; });
+            if (!ok) cerr << arg << " must all be at least " << low << endl;
+            return ok;
+        };
+        if (arg == "--map") {
+            if (!file(mapFile)) return false;
+        } else if (arg == "--order") {
+            if (!file(orderFile)) return false;
+        } else if (arg == "--order-stream") {
+            if (!file(orderStream)) return false;
+        } else if (arg == "--order-follow") {
+            orderFollow = true;
+        } else if (arg == "--stream-queue") {
+            if (!atLeast(streamQueue, 1)) return false;
+        } else if (arg == "--path") {
+            if (!file(pathFile)) return false;
+        } else if (arg == "--sa-path") {
+            if (!file(saPathFile)) return false;
+        } else if (arg == "--traj2text") {
+            if (!file(trajToText)) return false;
+        } else if (arg == "--profile") {
+            if (!file(profileFile)) return false;
+        } else if (arg == "--agvs") {
+            if (!atLeast(agvs, 1)) return false;
+        } else if (arg == "--orders") {
+            if (!atLeast(orders, 1)) return false;
+        } else if (arg == "--ticks") {
+            if (!atLeast(ticks, 1)) return false;
+        } else if (arg == "--tick-ms") {
+            if (!real(tickMs, 0)) return false;
+        } else if (arg == "--capacity") {
+            if (!atLeast(capacity, 1)) return false;
+        } else if (arg == "--dispatch") {
+            val v = next();
+            if (v == "greedy") {
+                dispatch = Dispatch::Greedy;
+            } else if (v == "batch") {
+                dispatch = Dispatch::Batch;
+            } else {
+                cerr << "unknown dispatch " << v << endl;
+                return false;
+            }
+        } else if (arg == "--planner") {
+            val v = next();
+            if (v == "blocked") {
+                planner = Planner::Blocked;
+            } else if (v == "cooperative") {
+                planner = Planner::Cooperative;
+            } else {
+                cerr << "unknown planner " << v << endl;
+                return false;
+            }
+        } else if (arg == "--window") {
+            if (!atLeast(window, 2)) return false;
+            if (window > Reservations::MAX_WINDOW) {
+                cerr << arg << " must be at most " << Reservations::MAX_WINDOW << endl;
+                return false;
+            }
+        } else if (arg == "--lookahead") {
+            if (!atLeast(lookahead, 1)) return false;
+        } else if (arg == "--online-sa") {
+            if (!atLeast(onlineSa, 0)) return false;
+        } else if (arg == "--online-sa-ms") {
+            if (!real(onlineSaMs, 0)) return false;
+        } else if (arg == "--threads") {
+            if (!atLeast(threads, 0)) return false;
+        } else if (arg == "--dist-cache") {
+            if (!file(distCache)) return false;
+        } else if (arg == "--no-dist-cache") {
+            distCache = "";
+        } else if (arg == "--dist-budget") {
+            var mib = 0.0;
+            if (!real(mib, 0)) return false;
+            distBudget = (size_t)(mib * 1024 * 1024);
+        } else if (arg == "--apsp-backend") {
+            val v = next();
+            if (v == "queue") {
+                apspBackend = ApspBackend::Queue;
+            } else if (v == "bitboard") {
+                apspBackend = ApspBackend::Bitboard;
+            } else {
+                cerr << "unknown apsp backend " << v << endl;
+                return false;
+            }
+        } else if (arg == "--landmarks") {
+            if (!atLeast(landmarks, 0)) return false;
+        } else if (arg == "--event-driven") {
+            eventDriven = true;
+        } else if (arg == "--bench-apsp") {
+            benchApsp = true;
+        } else if (arg == "--bench-alt") {
+            benchAlt = true;
+        } else if (arg == "--bench-block") {
+            benchBlock = true;
+        } else if (arg == "--bench-trip") {
+            benchTrip = true;
+        } else if (arg == "--bench-fleet") {
+            benchFleet = true;
+        } else if (arg == "--sweep") {
+            if (!file(sweepFile)) return false;
+        } else if (arg == "--sweep-agvs") {
+            if (!allAtLeast(sweepAgvs, 1)) return false;
+        } else if (arg == "--sweep-capacity") {
+            if (!allAtLeast(sweepCapacity, 1)) return false;
+        } else if (arg == "--sweep-seeds") {
+            if (!atLeast(sweepSeeds, 1)) return false;
+        } else if (arg == "--fork-at") {
+            if (!atLeast(forkAt, 0)) return false;
+        } else if (arg == "--down-agvs") {
+            if (!numbers(downAgvs)) return false;
+        } else if (arg == "--checkpoint") {
+            if (!file(checkpoint)) return false;
+        } else if (arg == "--resume") {
+            if (!file(resume)) return false;
+        } else {
+            cerr << "unknown option " << arg << endl;
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "graph.hpp"
+#include "top.hpp"
+
+// how greedy4simulate hands out orders
+enum class Dispatch {
+    Greedy, // next order to the first idle agv that takes it
+    Batch,  // min total extra travel over idle agvs and a window of pending orders
+};
+
+// how greedy4simulate moves agvs
+enum class Planner {
+    Blocked,     // shortest path around the cells other agvs are on now
+    Cooperative, // windowed cooperative A* over a space-time reservation table
+};
+
+// runtime knobs, filled from the command line
+struct Config {
+    string mapFile = map_file;
+    string orderFile = order_file;
+    string orderStream;       // "-" -> stdin, or a fifo or file read while running; empty -> orderFile upfront
+    bool orderFollow = false; // keep reading orderStream at its end until an "end" line
+    int streamQueue = 1024;   // orders the stream reader runs ahead of the simulation
+    string pathFile = greedy4simulate_path_file;       // *.traj -> binary trajectory streamed while running, else text
+    string saPathFile = sa4lowerbound_path_file;       // the same for sa4lowerbound's schedule
+    string trajToText;                                 // print this trajectory as a text path file and exit
+    string profileFile = greedy4simulate_profile_file; // builds with -DSIM_PROFILE only, empty -> not written
+    int agvs = MAX_AGV;     // one per 'P' cell of the map at most
+    int orders = MAX_ORDER; // capped at the orders in orderFile
+    int ticks = 1000;       // greedy4simulate clock limit
+    double tickMs = 0;      // wall time a full tick takes at least, 0 -> as fast as possible
+    int capacity = MAX_AGV_TASK; // orders an agv carries before going to sendArea
+    Dispatch dispatch = Dispatch::Greedy;
+    int lookahead = 8;      // pending orders the batch dispatcher looks at
+    Planner planner = Planner::Blocked;
+    int window = 16;        // ticks a cooperative plan reserves ahead, 2 to Reservations::MAX_WINDOW
+    int onlineSa = 0;       // ticks between background sa re-plans, 0 -> off
+    double onlineSaMs = 20; // time box of one re-plan
+    int threads = 0; // 0 -> hardware_concurrency
+    string distCache = dist_cache_file; // empty -> always rebuild
+    size_t distBudget = 0;              // bytes for distances, 0 -> unlimited
+    ApspBackend apspBackend = ApspBackend::Queue;
+    int landmarks = 0; // alt landmarks for A*, 0 -> exact distances
+    bool eventDriven = false; // greedy4simulate jumps over ticks where agvs only follow their plans
+    bool benchApsp = false;
+    bool benchAlt = false;
+    bool benchBlock = false;
+    bool benchTrip = false;
+    bool benchFleet = false;
+    string sweepFile;                      // csv of a parallel parameter sweep, empty -> no sweep
+    vector<int> sweepAgvs = {1, 2, 3, 4};  // fleet sizes
+    vector<int> sweepCapacity = {1, 3, 5}; // agv capacities
+    int sweepSeeds = 16;                   // generated order sets per order mix
+    int forkAt = 0;                        // what-if branches split after this tick, 0 -> no what-if
+    vector<int> downAgvs;                  // one what-if branch per agv, it breaks down at forkAt
+    string checkpoint;                     // what-if: save the state at forkAt
+    string resume;                         // what-if: start from this checkpoint instead of tick 0
+    //
+    bool parse(int argc, char **argv);
+    ApspOptions apspOptions() const { return {threads, apspBackend, distCache, distBudget, landmarks}; }
+};
@@ -0,0 +1,79 @@
+// system headers first, they must not see the var/val macros from top.hpp
+#include <cstdlib>
+
+#include "../common/distCache.hpp"
+#include "distTable.hpp"
+
+void DistTable::remap(ref<matrix<char>> grid, char free) {
+    rows = grid.size();
+    cols = rows ? grid[0].size() : 0;
+    slotOf.assign(rows * cols, -1);
+    cellOf.clear();
+    // walk 4x4 blocks in row-major order, cells inside a block in row-major order
+    for (var br = 0; br < rows; br += BLOCK) {
+        for (var bc = 0; bc < cols; bc += BLOCK) {
+            for (var r = br; r < min(rows, br + BLOCK); r++) {
+                for (var c = bc; c < min(cols, bc + BLOCK); c++) {
+                    if (c >= (int)grid[r].size() || grid[r][c] != free) continue;
+                    slotOf[r * cols + c] = cellOf.size();
+                    cellOf.push_back(r * cols + c);
+                }
+            }
+        }
+    }
+    slots = cellOf.size();
+    tiles = (slots + TILE - 1) / TILE;
+    entries = (size_t)tiles * (tiles + 1) / 2 * TILE * TILE;
+}
+
+void DistTable::init(ref<matrix<char>> grid, char free) {
+    remap(grid, free);
+    // one aligned block, rounded up to whole cache lines
+    val lineBytes = (bytes() + 63) / 64 * 64;
+    data = static_cast<uint16_t *>(std::aligned_alloc(64, max<size_t>(lineBytes, 64)));
+    storage = std::shared_ptr<void>(data, std::free);
+    clear();
+}
+
+void DistTable::clear() { std::fill(data, data + entries, INF); }
+
+size_t DistTable::index(int su, int sv) const {
+    if (su < sv) std::swap(su, sv);
+    val tu = (size_t)su / TILE, tv = (size_t)sv / TILE;
+    return (tu * (tu + 1) / 2 + tv) * TILE * TILE + (su % TILE) * TILE + sv % TILE;
+}
+
+int DistTable::get(int u, int v) const {
+    if (u == v) return 0;
+    val su = slotOf[u], sv = slotOf[v];
+    if (su < 0 || sv < 0) return INT_SOFT_MAX;
+    val d = getSlot(su, sv);
+    return d == INF ? INT_SOFT_MAX : d;
+}
+
+namespace {
+DistCacheHeader cacheHeader(ref<DistTable> table, uint64_t hash) {
+    DistCacheHeader h;
+    h.hash = hash;
+    h.rows = table.rows;
+    h.cols = table.cols;
+    h.entrySize = sizeof(uint16_t);
+    h.layout = DistTable::TILE;
+    h.entries = table.entries;
+    return h;
+}
+} // namespace
+
+bool DistTable::load(string filename, uint64_t hash, ref<matrix<char>> grid, char free) {
+    remap(grid, free);
+    std::shared_ptr<void> mapped;
+    val table = loadDistCache(filename, cacheHeader(*this, hash), mapped);
+    if (table == nullptr) return false;
+    data = static_cast<uint16_t *>(table);
+    storage = mapped;
+    return true;
+}
+
+bool DistTable::save(string filename, uint64_t hash) const {
+    return data != nullptr && saveDistCache(filename, cacheHeader(*this, hash), data);
+}
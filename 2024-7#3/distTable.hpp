@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include "top.hpp"
+
+// symmetric all-pairs table over reachable cells only
+// cells are remapped to dense slots in 4x4 spatial blocks, so the four neighbours of a cell usually share a tile
+// the lower triangle is stored as TILE x TILE tiles of uint16 in one cache-line aligned buffer
+struct DistTable {
+    static constexpr uint16_t INF = 0xffff;
+    static constexpr int TILE = 16;
+    static constexpr int BLOCK = 4; // spatial block edge, BLOCK * BLOCK == TILE
+    //
+    vector<int> slotOf; // cell id -> slot, -1 if not reachable
+    vector<int> cellOf; // slot -> cell id
+    int rows = 0;
+    int cols = 0;
+    int slots = 0;
+    int tiles = 0;
+    size_t entries = 0;
+    uint16_t *data = nullptr;
+    std::shared_ptr<void> storage; // owns data
+    //
+    DistTable() = default;
+    //
+    void remap(ref<matrix<char>> grid, char free); // build slot remap only
+    void init(ref<matrix<char>> grid, char free);  // remap and allocate, all entries INF
+    void clear();
+    size_t bytes() const { return entries * sizeof(uint16_t); }
+    size_t index(int su, int sv) const; // slots
+    uint16_t getSlot(int su, int sv) const { return data[index(su, sv)]; }
+    void setSlot(int su, int sv, uint16_t d) { data[index(su, sv)] = d; }
+    int get(int u, int v) const; // cell ids, INT_SOFT_MAX if unreachable
+    // on-disk cache in the shared DistCacheHeader format, mapped copy-on-write when loading
+    bool load(string filename, uint64_t hash, ref<matrix<char>> grid, char free);
+    bool save(string filename, uint64_t hash) const;
+};
+
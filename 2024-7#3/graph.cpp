@@ -1,4 +1,9 @@
+#include "../common/distCache.hpp"
+
 #include "graph.hpp"
+#include "bitBfs.hpp"
+#include "profiler.hpp"
+#include "threadPool.hpp"
 
 int v2id(int r, int c, int cols) { return r * cols + c; }
 
@@ -6,7 +11,9 @@ pii id2v(int id, int cols) { return {id / cols, id % cols}; }
 
 // Graph
 
-bool Graph::reachable(int r, int c) { return grid[r][c] == 'o'; }
+bool Graph::reachable(int r, int c) const { return grid[r][c] == 'o'; }
+
+uint64_t Graph::hash() const { return gridHash(grid); }
 
 bool Graph::input(string filename) {
     {
@@ -22,76 +29,294 @@ bool Graph::input(string filename) {
     rows = grid.size();
     cols = grid[0].size();
     nodes = rows * cols;
-    graph.resize(nodes);
-    for (int r = 0; r < rows; r++) {
-        for (int c = 0; c < cols; c++) {
-            if (!reachable(r, c)) continue;
-            val u = v2id(r, c, cols);
-            for (int i = 0; i < 4; i++) {
-                val tr = r + dr[i];
-                val tc = c + dc[i];
-                if (tr < 0 || tr >= rows || tc < 0 || tc >= cols) continue;
-                if (!reachable(tr, tc)) continue;
-                val v = v2id(tr, tc, cols);
-                graph[u].push_back(v);
-                val id = id2v(v, cols);
-            }
+    parking.clear();
+    for (var r = 0; r < rows; r++) {
+        for (var c = 0; c < (int)grid[r].size(); c++) {
+            if (grid[r][c] != 'P') continue;
+            parking.push_back({r, c});
+            grid[r][c] = 'o';
         }
     }
+    buildGraph();
     return true;
 }
 
-void Graph::solveShortestPath() {
-    fun bfs = [=](int start) {
-        vector<int> dis(graph.size(), INT_SOFT_MAX);
-        vector<int> vis(graph.size(), 0);
+void Graph::buildGraph() {
+    graph.build(nodes, [&](int u, auto emit) {
+        val [r, c] = id2v(u, cols);
+        if (!reachable(r, c)) return;
+        for (int i = 0; i < 4; i++) {
+            val tr = r + dr[i];
+            val tc = c + dc[i];
+            if (tr < 0 || tr >= rows || tc < 0 || tc >= cols) continue;
+            if (!reachable(tr, tc)) continue;
+            emit(v2id(tr, tc, cols));
+        }
+    });
+}
+
+bool Graph::solveShortestPath(int threads, ApspBackend backend) {
+    // uint16 entries would wrap, check before allocating slots^2 of them
+    dist.remap(grid, 'o');
+    if (dist.slots >= DistTable::INF) {
+        dist.data = nullptr;
+        dist.storage.reset();
+        return false;
+    }
+    // preallocate the whole table, every bfs writes its row in place
+    dist.init(grid, 'o');
+    fun bfs = [&](int slot, vector<int> &dis, vector<int> &q) {
+        val start = dist.cellOf[slot];
+        var head = 0, tail = 0;
         dis[start] = 0;
-        queue<int> q;
-        q.push(start);
-        vis[start] = 1;
-        while (!q.empty()) {
-            val u = q.front();
-            q.pop();
+        q[tail++] = start;
+        while (head < tail) {
+            val u = q[head++];
+            // the table is symmetric, the row only keeps slots up to its own
+            val su = dist.slotOf[u];
+            if (su <= slot) dist.setSlot(slot, su, dis[u]);
             for (val v : graph[u]) {
-                if (vis[v]) continue;
+                if (dis[v] != INT_SOFT_MAX) continue;
                 dis[v] = dis[u] + 1;
-                vis[v] = 1;
-                q.push(v);
+                q[tail++] = v;
             }
         }
-        return dis;
+        for (var i = 0; i < tail; i++) dis[q[i]] = INT_SOFT_MAX;
+    };
+    BitGrid bits;
+    if (backend == ApspBackend::Bitboard) bits.init(grid, 'o');
+    fun bitBfs = [&](int slot, BitGrid::Scratch &scratch) {
+        val [r, c] = id2v(dist.cellOf[slot], cols);
+        bits.bfs(r, c, scratch, [&](int tr, int tc, int d) {
+            val su = dist.slotOf[v2id(tr, tc, cols)];
+            if (su <= slot) dist.setSlot(slot, su, d);
+        });
     };
     //
-    dist.resize(graph.size());
-    for (var u = 0; u < graph.size(); u++) { dist[u] = bfs(u); }
+    val slots = dist.slots;
+    ThreadPool pool(min(resolveThreads(threads), max(1, slots)));
+    val grain = max(1, slots / (pool.size() * 8));
+    pool.parallelFor((slots + grain - 1) / grain, [&](int chunk) {
+        val begin = chunk * grain, end = min(slots, (chunk + 1) * grain);
+        if (backend == ApspBackend::Bitboard) {
+            BitGrid::Scratch scratch;
+            for (var s = begin; s < end; s++) bitBfs(s, scratch);
+        } else {
+            vector<int> dis(nodes, INT_SOFT_MAX), q(nodes);
+            for (var s = begin; s < end; s++) bfs(s, dis, q);
+        }
+    });
+    return true;
+}
+
+void Graph::solveShortestPath(ref<ApspOptions> options) {
+    lazy = LazyDist();
+    alt = Landmarks();
+    dist.remap(grid, 'o');
+    val tooMany = dist.slots >= DistTable::INF;
+    if (tooMany || options.landmarks > 0 || (options.budgetBytes > 0 && dist.bytes() > options.budgetBytes)) {
+        // keep the slot remap only, rows are filled on demand; landmarks stand in for the table in A*
+        if (tooMany) cerr << "too many cells for a uint16 distance table, rows are computed lazily" << endl;
+        dist.data = nullptr;
+        dist.storage.reset();
+        lazy.init(dist.slots, options.budgetBytes > 0 ? options.budgetBytes : LazyDist::DEFAULT_BYTES);
+    } else if (options.cacheFile.empty()) {
+        solveShortestPath(options.threads, options.backend);
+    } else if (val h = hash(); !dist.load(options.cacheFile, h, grid, 'o')) {
+        solveShortestPath(options.threads, options.backend);
+        if (!dist.save(options.cacheFile, h)) DEBUG("write distance cache error");
+    }
+    if (options.landmarks > 0) alt.build(graph, dist, options.landmarks);
+}
+
+namespace {
+struct Change {
+    int su, sv;
+    uint16_t d;
+};
+
+// x is about to close: per source row, the cells whose every shortest path runs through x are found level by level
+// from x, then get new distances from their unaffected neighbours by a dijkstra inside that set
+// reads only old entries, so the result can be applied after all rows are done
+vector<Change> repairClosed(ref<Graph> G, int x) {
+    ref<DistTable> dist = G.dist;
+    val INF = DistTable::INF;
+    vector<Change> changes;
+    vector<int> mark(G.nodes, -1), affected, d(G.nodes);
+    for (var s = 0; s < dist.slots; s++) {
+        fun old = [&](int v) { return (int)dist.getSlot(s, dist.slotOf[v]); };
+        if (old(x) == INF) continue;
+        // affected: x, then any child of an affected cell whose parents are all affected
+        affected = {x};
+        mark[x] = s;
+        for (size_t head = 0; head < affected.size(); head++) {
+            val u = affected[head];
+            for (val v : G.graph[u]) {
+                if (mark[v] == s || old(v) != old(u) + 1) continue;
+                var orphan = true;
+                for (val w : G.graph[v]) {
+                    if (old(w) == old(v) - 1 && mark[w] != s) orphan = false;
+                }
+                if (!orphan) continue;
+                mark[v] = s;
+                affected.push_back(v);
+            }
+        }
+        priority_queue<pii, vector<pii>, std::greater<pii>> q;
+        for (val v : affected) {
+            d[v] = INF;
+            if (v == x) continue;
+            for (val w : G.graph[v]) {
+                if (mark[w] != s) d[v] = min(d[v], old(w) + 1);
+            }
+            if (d[v] != INF) q.push({d[v], v});
+        }
+        while (!q.empty()) {
+            val [dv, v] = q.top();
+            q.pop();
+            if (dv != d[v]) continue;
+            for (val w : G.graph[v]) {
+                if (mark[w] != s || w == x || d[w] <= dv + 1) continue;
+                d[w] = dv + 1;
+                q.push({d[w], w});
+            }
+        }
+        for (val v : affected) {
+            val sv = dist.slotOf[v];
+            if (sv <= s && d[v] != old(v)) changes.push_back({s, sv, (uint16_t)d[v]});
+        }
+    }
+    return changes;
+}
+
+// x has just reopened: per source row its distance is one more than its best neighbour, and the decrease spreads
+// by bfs only through cells that get closer; x's own row is a plain bfs
+vector<Change> repairOpened(ref<Graph> G, int x) {
+    ref<DistTable> dist = G.dist;
+    val INF = DistTable::INF;
+    val sx = dist.slotOf[x];
+    vector<Change> changes;
+    vector<int> mark(G.nodes, -1), d(G.nodes), q;
+    for (var s = 0; s < dist.slots; s++) {
+        // overlay of this row's new values
+        fun cur = [&](int v) { return mark[v] == s ? d[v] : (int)dist.getSlot(s, dist.slotOf[v]); };
+        var dx = s == sx ? 0 : (int)INF;
+        for (val w : G.graph[x]) dx = min(dx, cur(w) + 1);
+        if (dx >= INF) continue;
+        mark[x] = s;
+        d[x] = dx;
+        q = {x};
+        for (size_t head = 0; head < q.size(); head++) {
+            val u = q[head];
+            for (val v : G.graph[u]) {
+                if (cur(v) <= d[u] + 1) continue;
+                mark[v] = s;
+                d[v] = d[u] + 1;
+                q.push_back(v);
+            }
+        }
+        for (val v : q) {
+            val sv = dist.slotOf[v];
+            if (sv <= s) changes.push_back({s, sv, (uint16_t)d[v]});
+        }
+    }
+    return changes;
+}
+} // namespace
+
+size_t Graph::setBlocked(int r, int c, bool blocked) {
+    if (grid[r][c] != (blocked ? 'o' : BLOCKED)) return 0;
+    val x = v2id(r, c, cols);
+    val table = !lazy.enabled() && dist.data != nullptr;
+    vector<Change> changes;
+    // closing reads the old adjacency, reopening the new one
+    if (blocked && table) changes = repairClosed(*this, x);
+    grid[r][c] = blocked ? BLOCKED : 'o';
+    buildGraph();
+    var touched = (size_t)0;
+    if (!blocked && dist.slotOf[x] < 0) {
+        // closed before the distances were set up, there is no slot to repair
+        if (table && solveShortestPath()) {
+            touched = dist.entries;
+        } else if (table) {
+            // the reopened cell took the last slot a uint16 table can hold
+            lazy.init(dist.slots, LazyDist::DEFAULT_BYTES);
+        } else if (lazy.enabled()) {
+            dist.remap(grid, 'o');
+            lazy.init(dist.slots, lazy.budget());
+        }
+    } else if (!blocked && table) {
+        changes = repairOpened(*this, x);
+    }
+    for (val &[su, sv, d] : changes) dist.setSlot(su, sv, d);
+    if (lazy.enabled()) lazy.clear();
+    if (alt.enabled()) alt.build(graph, dist, alt.count());
+    return touched + changes.size();
 }
 
 int Graph::shortestPath(int fromR, int fromC, int toR, int toC) const {
-    return dist[v2id(fromR, fromC, cols)][v2id(toR, toC, cols)];
+    return distance(v2id(fromR, fromC, cols), v2id(toR, toC, cols));
 }
 
 vector<pii> Graph::traceSimplePath(int fromR, int fromC, int toR, int toC) const {
-    priority_queue<pii, vector<pii>, std::greater<pii>> q;
-    q.push({0, v2id(fromR, fromC, cols)});
-    vector<int> vis(nodes, 0);
-    vector<int> pre(nodes, -1);
+    // walk down the distance gradient, every step is a neighbour one closer to the goal
     val goalId = v2id(toR, toC, cols);
-    // A*
-    [&]() {
-        while (!q.empty()) {
-            auto [dis, u] = q.top();
-            q.pop();
-            vis[u] = 1;
-            for (val v : graph[u]) {
-                if (vis[v]) continue;
-                pre[v] = u;
-                if (v == goalId) return;
-                val vv = id2v(v, cols);
-                q.push({dis + 1 + shortestPath(vv[0], vv[1], toR, toC), v});
+    var u = v2id(fromR, fromC, cols);
+    var d = distance(u, goalId);
+    if (d >= INT_SOFT_MAX) return {{toR, toC}};
+    vector<pii> ret;
+    ret.reserve(d + 1);
+    ret.push_back({fromR, fromC});
+    while (d > 0) {
+        for (val v : graph[u]) {
+            if (distance(v, goalId) != d - 1) continue;
+            u = v;
+            break;
+        }
+        d--;
+        ret.push_back(id2v(u, cols));
+    }
+    return ret;
+}
+
+vector<pii> Graph::searchPath(int fromId, int goalId, ref<std::function<bool(int)>> blocked, int limit,
+                              int *expanded) const {
+    // scratch is reused between calls, `stamp` marks which entries belong to this search
+    thread_local vector<int> seen, pre;
+    thread_local int stamp = 0;
+    if ((int)seen.size() != nodes) {
+        seen.assign(nodes, 0);
+        pre.assign(nodes, -1);
+        stamp = 0;
+    }
+    stamp++;
+    priority_queue<pii, vector<pii>, std::greater<pii>> q;
+    fun h = [&](int u) { return heuristic(u, goalId); };
+    q.push({h(fromId), fromId});
+    seen[fromId] = stamp;
+    pre[fromId] = -1;
+    var found = fromId == goalId;
+    // A*, g is recovered from f - h
+    var count = 0;
+    for (; !found && !q.empty() && count < limit; count++) {
+        val [f, u] = q.top();
+        q.pop();
+        val g = f - h(u);
+        for (val v : graph[u]) {
+            if (seen[v] == stamp || blocked(v)) continue;
+            seen[v] = stamp;
+            pre[v] = u;
+            if (v == goalId) {
+                found = true;
+                break;
             }
+            q.push({g + 1 + h(v), v});
         }
-    }();
-    // trace
+    }
+    if (expanded != nullptr) *expanded += count;
+    PROFILE_COUNT(Searches, 1);
+    PROFILE_COUNT(Expanded, count);
+    if (!found) return {};
     vector<pii> ret;
     for (var u = goalId; u != -1; u = pre[u]) ret.push_back(id2v(u, cols));
     reverse(ret.begin(), ret.end());
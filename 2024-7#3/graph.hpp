@@ -1,25 +1,57 @@
 #pragma once
 
+#include "csr.hpp"
+#include "distTable.hpp"
+#include "landmarks.hpp"
+#include "lazyDist.hpp"
 #include "top.hpp"
 
 const int dr[] = {-1, 0, 1, 0};
 const int dc[] = {0, 1, 0, -1};
-const int INT_SOFT_MAX = 1e9 + 7;
+
+enum class ApspBackend { Queue, Bitboard };
+
+struct ApspOptions {
+    int threads = 0; // 0 -> hardware_concurrency
+    ApspBackend backend = ApspBackend::Queue;
+    string cacheFile;       // empty -> always rebuild
+    size_t budgetBytes = 0; // 0 -> unlimited, over it rows are computed lazily
+    int landmarks = 0;      // > 0 -> A* searches use alt bounds from this many landmarks, no table, lazy rows
+};
 
 struct Graph {
+    static constexpr char BLOCKED = 'b'; // free cell closed at runtime
+    //
     matrix<char> grid;
-    matrix<int> graph;
-    matrix<int> dist; // shortest distance, using id
+    Csr graph; // 4-neighbour adjacency between reachable cells
+    DistTable dist; // shortest distance between reachable cells
+    LazyDist lazy;  // on-demand rows instead, when the full table is over budget
+    Landmarks alt;  // lower bounds for A*, when built
     int cols = 0, rows = 0;
     int nodes = 0;
+    vector<pii> parking; // 'P' cells in row-major order, agv rest areas; input() turns them into free cells
     //
     Graph() = default;
     //
+    int distance(int u, int v) const { return lazy.enabled() ? lazy.get(graph, dist, u, v) : dist.get(u, v); }
+    int heuristic(int u, int v) const { return alt.enabled() ? alt.bound(dist, u, v) : distance(u, v); }
     int shortestPath(int fromR, int fromC, int toR, int toC) const;
+    uint64_t hash() const; // fnv-1a over the grid, keys the distance cache
     bool input(string filename);
-    bool reachable(int r, int c);
-    void solveShortestPath();
-    vector<pii> traceSimplePath(int fromR, int fromC, int toR, int toC) const;
+    bool reachable(int r, int c) const;
+    void buildGraph(); // csr from the current grid
+    // all-pairs bfs, sources split across threads; false and no table if the cells do not fit uint16 distances
+    bool solveShortestPath(int threads = 0, ApspBackend backend = ApspBackend::Queue);
+    // map the cache if valid, else solve and write it; with landmarks, over the budget or past uint16 distances
+    // switch to lazy rows; then pick landmarks
+    void solveShortestPath(ref<ApspOptions> options);
+    // close a free cell or reopen a closed one, repairing only the distance entries that change
+    // returns how many entries were rewritten; lazy rows are dropped instead, landmarks rebuilt
+    size_t setBlocked(int r, int c, bool blocked);
+    vector<pii> traceSimplePath(int fromR, int fromC, int toR, int toC) const; // O(path length) from dist
+    // bounded A* over cell ids avoiding `blocked`, gives up after `limit` expansions, adds them to `expanded`
+    vector<pii> searchPath(int fromId, int goalId, ref<std::function<bool(int)>> blocked, int limit,
+                           int *expanded = nullptr) const;
 };
 
 int v2id(int r, int c, int cols);
@@ -1,38 +1,40 @@
 #include "greedy4simulate.hpp"
 
+#include <cstring>
+#include <sstream>
+
+#include "profiler.hpp"
+#include "trajectory.hpp"
+
 // structs
 // GraphG
-vector<pii> GraphG::traceBlockedPath(ref<set<pii>> blocks, int fromR, int fromC, int toR, int toC) const {
+vector<pii> GraphG::traceBlockedPath(ref<Bitmap> blocks, int fromR, int fromC, int toR, int toC) const {
+    const int LOCAL_SEARCH_LIMIT = 1024;
     if (grid[toR][toC] != 'o') return {};
-    fun isBlock = [&](pii v) { return blocks.find(v) != blocks.end(); };
-    if (isBlock(pii{toR, toC})) return {};
-    priority_queue<pii, vector<pii>, std::greater<pii>> q;
-    q.push({0, v2id(fromR, fromC, cols)});
-    vector<int> vis(nodes, 0);
-    vector<int> pre(nodes, -1);
     val goalId = v2id(toR, toC, cols);
-    // A*
-    [&]() {
-        while (!q.empty()) {
-            auto [dis, u] = q.top();
-            q.pop();
-            if (vis[u]) continue;
-            vis[u] = 1;
-            for (val v : graph[u]) {
-                if (vis[v]) continue;
-                val vv = id2v(v, cols);
-                if (isBlock(vv)) continue;
-                pre[v] = u;
-                if (v == goalId) return;
-                q.push({dis + 1 + shortestPath(vv[0], vv[1], toR, toC), v});
-            }
-        }
-    }();
-    // trace
-    vector<pii> ret;
-    for (var u = goalId; u != -1; u = pre[u]) { ret.push_back(id2v(u, cols)); }
-    reverse(ret.begin(), ret.end());
-    return ret;
+    // an occupied goal is still planned to, the caller waits in front of it until it clears
+    fun isBlock = [&](int v) { return v != goalId && blocks.test(v); };
+    val fromId = v2id(fromR, fromC, cols);
+    var u = fromId;
+    var d = distance(u, goalId);
+    if (d >= INT_SOFT_MAX) return {};
+    // follow the distance gradient through free cells
+    vector<pii> ret = {{fromR, fromC}};
+    while (d > 0) {
+        var next = -1;
+        for (val v : graph[u]) {
+            if (distance(v, goalId) != d - 1 || isBlock(v)) continue;
+            next = v;
+            break;
+        }
+        if (next == -1) break;
+        u = next;
+        d--;
+        ret.push_back(id2v(u, cols));
+    }
+    if (d == 0) return ret;
+    // the gradient runs into an occupied cell, only now pay for a bounded search around it
+    return searchPath(fromId, goalId, isBlock, LOCAL_SEARCH_LIMIT);
 }
 pii GraphG::argAdjMin(int fromR, int fromC, int toR, int toC) const {
     int mn = INT_SOFT_MAX, mnIdx = 0;
@@ -47,133 +49,889 @@ pii GraphG::argAdjMin(int fromR, int fromC, int toR, int toC) const {
     }
     return {mn, mnIdx};
 }
-// Agv
-void Agv::setPosition(int r, int c) { position = {r, c}; }
+// Fleet
+void Fleet::init(ref<vector<pii>> rest, int capacity) {
+    size = rest.size();
+    this->capacity = capacity;
+    position = target = restPosition = rest;
+    storage.assign(size, 0);
+    plan.assign(size, {});
+    planAt.assign(size, 0);
+    waitKey.assign(size, 0);
+    retryAt.assign(size, 0);
+    detour.init(size);
+    idle.init(size);
+    down.init(size);
+}
+bool Fleet::mayTakeOrder(int idx) const {
+    if (down.test(idx)) return false;
+    return target[idx] == restPosition[idx] || position[idx] == restPosition[idx] ||
+           (target[idx] == sendArea && storage[idx] != capacity);
+}
+// SimState
+bool SimState::init(ref<Config> cfg, ref<GraphG> G, ref<Order> orders) {
+    if ((int)G.parking.size() < cfg.agvs) {
+        cerr << "map has " << G.parking.size() << " 'P' cells for " << cfg.agvs << " agvs" << endl;
+        return false;
+    }
+    *this = {};
+    planner = cfg.planner;
+    O = {orders};
+    O.assigned.assign(O.orders, 0);
+    arrivedAt.assign(O.orders, 0);
+    F.init(vector<pii>(G.parking.begin(), G.parking.begin() + cfg.agvs), cfg.capacity);
+    planFrom.assign(F.size, 0);
+    planFor = F.target;
+    // cooperative mode: every agv holds a plan from the start
+    if (planner == Planner::Cooperative) {
+        reservations.init(G.nodes);
+        for (var idx = 0; idx < F.size; idx++) {
+            F.plan[idx] = {F.position[idx]};
+            reservations.reserve(F.plan[idx], G.cols, 0, 0);
+        }
+    }
+    return true;
+}
+namespace {
+const char STATE_MAGIC[4] = {'A', 'G', 'V', 'S'};
+const int STATE_VERSION = 3;
+
+// plain values and vectors of them, as their bytes
+template <typename T> void put(ofstream &fout, ref<T> v) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    fout.write(reinterpret_cast<const char *>(&v), sizeof(T));
+}
+template <typename T> void put(ofstream &fout, ref<vector<T>> v) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    put(fout, (int64_t)v.size());
+    fout.write(reinterpret_cast<const char *>(v.data()), v.size() * sizeof(T));
+}
+template <typename T> bool get(ifstream &fin, T &v) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    return (bool)fin.read(reinterpret_cast<char *>(&v), sizeof(T));
+}
+template <typename T> bool get(ifstream &fin, vector<T> &v) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    int64_t n;
+    if (!get(fin, n) || n < 0 || n > (1LL << 32)) return false;
+    v.resize(n);
+    return (bool)fin.read(reinterpret_cast<char *>(v.data()), n * sizeof(T));
+}
+} // namespace
+bool SimState::save(ref<string> file, ref<Graph> G) const {
+    ofstream fout(file, std::ios::binary);
+    if (!fout) return false;
+    fout.write(STATE_MAGIC, sizeof(STATE_MAGIC));
+    put(fout, STATE_VERSION);
+    put(fout, G.rows);
+    put(fout, G.cols);
+    put(fout, G.hash());
+    put(fout, clock);
+    put(fout, planner);
+    put(fout, stats);
+    put(fout, F.size);
+    put(fout, F.capacity);
+    for (val v : {&F.position, &F.target, &F.restPosition}) put(fout, *v);
+    put(fout, F.storage);
+    put(fout, F.planAt);
+    put(fout, F.waitKey);
+    put(fout, F.retryAt);
+    for (val &plan : F.plan) put(fout, plan);
+    for (val bits : {&F.detour, &F.idle, &F.down}) put(fout, bits->words);
+    put(fout, O.order);
+    put(fout, O.orders);
+    put(fout, O.nextAssignIndex);
+    put(fout, O.assigned);
+    put(fout, arrivedAt);
+    put(fout, waits);
+    put(fout, waitsMs);
+    std::ostringstream text; // the generator's own text form, the only portable one
+    text << rng;
+    val rngText = text.str();
+    put(fout, vector<char>(rngText.begin(), rngText.end()));
+    put(fout, reservations.bits);
+    put(fout, reservations.heldFrom);
+    put(fout, planFrom);
+    put(fout, planFor);
+    return (bool)fout;
+}
+bool SimState::load(ref<string> file, ref<Graph> G) {
+    ifstream fin(file, std::ios::binary);
+    char magic[sizeof(STATE_MAGIC)];
+    int version, rows, cols;
+    uint64_t hash;
+    if (!fin.read(magic, sizeof(magic)) || std::memcmp(magic, STATE_MAGIC, sizeof(magic)) != 0) return false;
+    if (!get(fin, version) || version != STATE_VERSION) return false;
+    if (!get(fin, rows) || !get(fin, cols) || !get(fin, hash)) return false;
+    if (rows != G.rows || cols != G.cols || hash != G.hash()) {
+        cerr << "checkpoint " << file << " was made on another map" << endl;
+        return false;
+    }
+    SimState s;
+    var ok = get(fin, s.clock) && get(fin, s.planner) && get(fin, s.stats);
+    ok = ok && get(fin, s.F.size) && get(fin, s.F.capacity) && s.F.size >= 0;
+    for (val v : {&s.F.position, &s.F.target, &s.F.restPosition}) ok = ok && get(fin, *v);
+    ok = ok && get(fin, s.F.storage) && get(fin, s.F.planAt);
+    ok = ok && get(fin, s.F.waitKey) && get(fin, s.F.retryAt);
+    s.F.plan.resize(ok ? s.F.size : 0);
+    for (var &plan : s.F.plan) ok = ok && get(fin, plan);
+    for (val bits : {&s.F.detour, &s.F.idle, &s.F.down}) ok = ok && get(fin, bits->words);
+    ok = ok && get(fin, s.O.order) && get(fin, s.O.orders) && get(fin, s.O.nextAssignIndex) && get(fin, s.O.assigned);
+    ok = ok && get(fin, s.arrivedAt) && get(fin, s.waits) && get(fin, s.waitsMs);
+    vector<char> rngText;
+    ok = ok && get(fin, rngText);
+    std::istringstream text(string(rngText.begin(), rngText.end()));
+    ok = ok && text >> s.rng;
+    ok = ok && get(fin, s.reservations.bits) && get(fin, s.reservations.heldFrom);
+    ok = ok && get(fin, s.planFrom) && get(fin, s.planFor);
+    // every per-agv and per-order array has to match the counts it was saved with
+    for (val n : {s.F.position.size(), s.F.target.size(), s.F.restPosition.size(), s.F.storage.size(),
+                  s.F.planAt.size(), s.F.waitKey.size(), s.F.retryAt.size(), s.planFrom.size(), s.planFor.size()}) {
+        ok = ok && (int)n == s.F.size;
+    }
+    for (val n : {s.O.order.size(), s.O.assigned.size(), s.arrivedAt.size()}) ok = ok && (int)n == s.O.orders;
+    for (val bits : {&s.F.detour, &s.F.idle, &s.F.down}) ok = ok && (int)bits->words.size() == (s.F.size + 63) / 64;
+    // the cooperative planner's table covers every cell, the blocked planner has none
+    val cells = s.planner == Planner::Cooperative ? G.nodes : 0;
+    ok = ok && (s.planner == Planner::Blocked || s.planner == Planner::Cooperative);
+    ok = ok && (int)s.reservations.bits.size() == cells && (int)s.reservations.heldFrom.size() == cells;
+    ok = ok && s.F.capacity >= 1 && s.O.nextAssignIndex >= 0 && s.O.nextAssignIndex <= s.O.orders;
+    if (!ok) return false;
+    // every cell an agv is on or heads to indexes per-cell tables, so it has to be on this map
+    fun onMap = [&](pii v) { return v[0] >= 0 && v[0] < G.rows && v[1] >= 0 && v[1] < G.cols; };
+    fun walkable = [&](pii v) { return onMap(v) && G.reachable(v[0], v[1]); };
+    for (var idx = 0; ok && idx < s.F.size; idx++) {
+        val &plan = s.F.plan[idx];
+        ok = walkable(s.F.position[idx]) && walkable(s.F.restPosition[idx]) && onMap(s.F.target[idx]) &&
+             onMap(s.planFor[idx]) && std::all_of(plan.begin(), plan.end(), walkable);
+        ok = ok && s.F.storage[idx] >= 0 && s.F.storage[idx] <= s.F.capacity;
+        ok = ok && s.F.planAt[idx] >= 0 && s.F.planAt[idx] < max(1, (int)plan.size());
+    }
+    ok = ok && std::all_of(s.O.order.begin(), s.O.order.end(), onMap);
+    if (!ok) return false;
+    *this = move(s);
+    return true;
+}
 //
 
-void greedy4simulate() {
-    DEBUG("begin greedy4simulate");
+namespace {
+// ticks a boxed-in agv waits before it searches for a way around again although nothing in its way changed
+const int RETRY_TICKS = 8;
 
-    // constants
-    const int SIM_CLOCK_MAX = 1000;
+// first tick, counted from the next one, that has to be simulated in full
+struct Event {
+    enum Kind { Arrival, Free, Conflict, Incoming } kind;
+    int tick;
+    int agv;
+    bool operator>(ref<Event> other) const { return tick > other.tick; }
+};
+} // namespace
 
-    // variables
-    GraphG G;
-    OrderG O;
+SimStats greedy4simulate(ref<Config> cfg, ref<GraphG> G, ref<Order> orders) {
+    SimState state;
+    if (!state.init(cfg, G, orders)) return state.stats;
+    return greedy4simulate(cfg, G, state, cfg.ticks);
+}
 
-    matrix<pii> paths(MAX_AGV);
-    vector<Agv> agvs;
+SimStats greedy4simulate(ref<Config> cfg, ref<GraphG> G, SimState &state, int until) {
+    // variables
+    var &O = state.O;
+    var &F = state.F;
+    var &stats = state.stats;
+    var &sim_clock = state.clock;
+    until = min(until, cfg.ticks);
+    if (state.planner != cfg.planner) {
+        cerr << "state was made for the other planner" << endl;
+        return stats;
+    }
+    if (stats.finished || sim_clock >= until) return stats;
 
-    int sim_clock = 0;
+    Bitmap blocks;
+    vector<int> holder; // agv last seen on each cell, stale unless its position still matches
 
     // init
-    G.input(map_file);
-    G.solveShortestPath();
-    O.input(order_file);
+    Timer simTimer;
+    var &arrivedAt = state.arrivedAt;
+    vector<std::chrono::steady_clock::time_point> readAt(O.orders, simTimer.startTime);
+    var &waits = state.waits;
+    var &waitsMs = state.waitsMs;
+    blocks.init(G.nodes);
+    holder.assign(G.nodes, -1);
 
     // simulate
-    agvs.resize(MAX_AGV);
-    for (var index = 0; index < MAX_AGV; index++) {
-        var &agv = agvs[index];
-        agv.restPosition = agvRestArea[index];
-        agv.position = agv.restPosition;
-        agv.id = index;
-        agv.target = agv.restPosition;
+    val agvs = F.size;
+    // positions per tick: streamed to a trajectory file, or kept per agv for the text file written at the end
+    matrix<pii> paths(agvs);
+    TrajectoryWriter trajectory;
+    if (isTrajectoryFile(cfg.pathFile) && !trajectory.open(cfg.pathFile, G.rows, G.cols, agvs)) {
+        cerr << "cannot write " << cfg.pathFile << endl;
+    }
+    fun report = [&]() {
+        if (trajectory.isOpen()) {
+            trajectory.write(F.position);
+        } else if (!cfg.pathFile.empty()) {
+            for (var idx = 0; idx < agvs; idx++) paths[idx].push_back(F.position[idx]);
+        }
+    };
+    fun cellId = [&](pii v) { return v2id(v[0], v[1], G.cols); };
+#ifdef SIM_PROFILE
+    TickProfile profile;
+    TickProfile::current = &profile;
+#endif
+
+    // streamed orders join O as their tick comes; `incoming` is read but not due yet when `held`
+    std::unique_ptr<OrderStream> stream;
+    if (!cfg.orderStream.empty()) {
+        stream = std::make_unique<OrderStream>(cfg.orderStream, cfg.streamQueue, cfg.orderFollow);
     }
+    var streamOpen = stream != nullptr;
+    var held = false;
+    StreamedOrder incoming;
+    fun onRack = [&](pii cell) {
+        if (cell[0] < 0 || cell[0] >= G.rows || cell[1] < 0 || cell[1] >= G.cols) return false;
+        for (var i = 0; i < 4; i++) {
+            val r = cell[0] + dr[i], c = cell[1] + dc[i];
+            if (r >= 0 && r < G.rows && c >= 0 && c < G.cols && G.reachable(r, c)) return true;
+        }
+        return false;
+    };
+    // paced, orders that are not read yet come in a later tick; as fast as possible it is a replay, and the clock only
+    // moves on once the reader is past it
+    fun admit = [&]() {
+        loop {
+            val closed = stream->closed.load();
+            if (!held && !stream->pop(incoming)) {
+                if (closed) {
+                    streamOpen = false;
+                    return false;
+                }
+                if (cfg.tickMs > 0) return false;
+                std::this_thread::yield();
+                continue;
+            }
+            held = true;
+            if (incoming.tick > sim_clock) return false;
+            held = false;
+            if (!onRack(incoming.cell)) {
+                stats.rejected++;
+                continue;
+            }
+            O.order.push_back(incoming.cell);
+            O.assigned.push_back(0);
+            O.orders++;
+            arrivedAt.push_back(sim_clock);
+            // a stamped order arrives with its tick, not when a replay happened to read it
+            readAt.push_back(incoming.tick > 0 ? std::chrono::steady_clock::now() : incoming.readAt);
+            return true;
+        }
+    };
+    fun assign = [&](int id) {
+        O.assigned[id] = 1;
+        waits.push_back(sim_clock - arrivedAt[id]);
+        val waited = std::chrono::steady_clock::now() - readAt[id];
+        waitsMs.push_back(std::chrono::duration<double, std::milli>(waited).count());
+    };
+
+    // event mode: how many ticks from the next one on do nothing but walk agvs along their plans
+    // those ticks assign nothing, replan nothing and nobody arrives, so they can be skipped as long as the path
+    // output still gets a position per tick
+    // per cell, the two earliest ticks of different agvs the move phase could see it taken: at tick k an agv holds
+    // plan[planAt + k], and plan[planAt + k + 1] too once it moved before the one checking
+    struct Visit {
+        int k = INT_SOFT_MAX, agv = -1;
+    };
+    vector<array<Visit, 2>> visits(G.nodes);
+    vector<int> touched;
+    fun visit = [&](int cell, int k, int agv) {
+        var &[first, second] = visits[cell];
+        if (first.agv == -1) touched.push_back(cell);
+        if (agv == first.agv) {
+            first.k = min(first.k, k);
+        } else if (k < first.k) {
+            second = first;
+            first = {k, agv};
+        } else if (agv == second.agv) {
+            second.k = min(second.k, k);
+        } else if (k < second.k) {
+            second = {k, agv};
+        }
+    };
+    fun quietTicks = [&]() {
+        // cooperative plans are short and refreshed on their own schedule
+        if (cfg.planner == Planner::Cooperative) return 0;
+        // an open stream with nothing read ahead may bring an order any tick
+        if (streamOpen && !held) return 0;
+        val ordersLeft = O.nextAssignIndex != O.orders;
+        vector<int> moving;
+        for (var idx = 0; idx < agvs; idx++) {
+            if (ordersLeft && F.mayTakeOrder(idx)) return 0;
+            if (!F.moving(idx)) continue;
+            // plan has to be made or is a one-step detour
+            val &plan = F.plan[idx];
+            if (plan.empty() || plan.back() != F.target[idx] || plan[F.planAt[idx]] != F.position[idx] ||
+                F.detour.test(idx))
+                return 0;
+            moving.push_back(idx);
+        }
+        if (moving.empty()) return 0;
+        priority_queue<Event, vector<Event>, std::greater<Event>> events;
+        if (streamOpen) events.push({Event::Incoming, incoming.tick - sim_clock - 1, -1});
+        for (val idx : moving) {
+            val &plan = F.plan[idx];
+            val rest = (int)plan.size() - 1 - F.planAt[idx];
+            events.push({Event::Arrival, rest - 1, idx});
+            for (var k = 1; ordersLeft && k < rest; k++) {
+                if (plan[F.planAt[idx] + k] != F.restPosition[idx]) continue;
+                events.push({Event::Free, k, idx});
+                break;
+            }
+        }
+        val horizon = min(until - sim_clock, events.top().tick);
+        for (var idx = 0; idx < agvs; idx++) {
+            if (!F.moving(idx)) {
+                visit(cellId(F.position[idx]), 0, idx);
+                continue;
+            }
+            val &plan = F.plan[idx];
+            for (var j = 0; j <= min(horizon + 1, (int)plan.size() - 1 - F.planAt[idx]); j++)
+                visit(cellId(plan[F.planAt[idx] + j]), max(0, j - 1), idx);
+        }
+        // a conflict is a cell on the rest of a plan that someone else holds before the plan gets there
+        for (val a : moving) {
+            val &plan = F.plan[a];
+            var first = INT_SOFT_MAX;
+            for (var i = 1; F.planAt[a] + i < (int)plan.size(); i++) {
+                val &[v1, v2] = visits[cellId(plan[F.planAt[a] + i])];
+                val k = v1.agv != a ? v1.k : v2.k;
+                if (k < i) first = min(first, k);
+            }
+            if (first < horizon) events.push({Event::Conflict, first, a});
+        }
+        for (val cell : touched) visits[cell] = {};
+        touched.clear();
+        val next = events.top();
+        stats.events[next.kind]++;
+        return max(0, min(horizon, next.tick));
+    };
+
+    // travel an idle agv adds to take `task` and the pick cell it would drive to, INT_SOFT_MAX if it does not take it
+    // an agv heading to sendArea picks it up on the way only if that beats a separate round trip
+    fun extraTravel = [&](int idx, pii task) {
+        PROFILE_COUNT(DispatchTries, 1);
+        val [r, c] = F.position[idx];
+        auto [dis, dt] = G.argAdjMin(r, c, task[0], task[1]);
+        val pick = pii{task[0] + dr[dt], task[1] + dc[dt]};
+        val sDis = G.shortestPath(pick[0], pick[1], sendArea[0], sendArea[1]);
+        if (F.target[idx] == sendArea) {
+            val direct = G.shortestPath(r, c, sendArea[0], sendArea[1]);
+            if (dis + sDis >= direct + 2 * sDis) return pair{INT_SOFT_MAX, pick};
+            return pair{dis + sDis - direct, pick};
+        }
+        if (F.target[idx] != F.restPosition[idx]) return pair{INT_SOFT_MAX, pick};
+        return pair{dis + sDis, pick};
+    };
+    // idle agvs against the first cfg.lookahead pending orders, matched for the least total extra travel
+    // parked agvs: the other orders take at most lookahead - 1 of an order's lookahead cheapest, so an optimal matching
+    // never needs one outside them; the index ranks them by extra travel less the order's shortest way on to sendArea,
+    // the same order shifted to stay at least the path distance to the pick that the index prunes by
+    // agvs heading to sendArea are ranked by distance to the pick only, a heuristic that may miss a better detour
+    // the matching is solved afresh each tick: costs move with the agvs, so last tick's potentials no longer fit them
+    SpatialIndex parked, enRoute; // idle agvs heading to their rest cell, and to sendArea with room left
+    if (cfg.dispatch == Dispatch::Batch) {
+        parked.init(G.rows, G.cols, agvs);
+        enRoute.init(G.rows, G.cols, agvs);
+    }
+    fun assignBatch = [&]() {
+        vector<int> window;
+        for (var i = O.nextAssignIndex; i < O.orders && (int)window.size() < cfg.lookahead; i++) {
+            if (!O.assigned[i]) window.push_back(i);
+        }
+        if (window.empty()) return;
+        vector<int> free;
+        // with few idle agvs the queries would return about all of them anyway
+        val few = parked.size() + enRoute.size() <= 2 * (int)(window.size() * window.size());
+        for (var idx = 0; few && idx < agvs; idx++) {
+            if (parked.contains(idx) || enRoute.contains(idx)) free.push_back(idx);
+        }
+        for (var j = 0; !few && j < (int)window.size(); j++) {
+            val task = O.order[window[j]];
+            var toSend = INT_SOFT_MAX;
+            for (var i = 0; i < 4; i++) {
+                val r = task[0] + dr[i], c = task[1] + dc[i];
+                if (r < 0 || r >= G.rows || c < 0 || c >= G.cols || !G.reachable(r, c)) continue;
+                toSend = min(toSend, G.shortestPath(r, c, sendArea[0], sendArea[1]));
+            }
+            fun extra = [&](int idx) {
+                val cost = extraTravel(idx, task).first;
+                return cost >= INT_SOFT_MAX ? INT_SOFT_MAX : cost - toSend;
+            };
+            fun dis = [&](int idx) { return G.argAdjMin(F.position[idx][0], F.position[idx][1], task[0], task[1])[0]; };
+            for (val [d, idx] : parked.nearest(task, window.size(), extra)) free.push_back(idx);
+            for (val [d, idx] : enRoute.nearest(task, window.size(), dis)) free.push_back(idx);
+        }
+        std::sort(free.begin(), free.end());
+        free.erase(std::unique(free.begin(), free.end()), free.end());
+        if (free.empty()) return;
+        matrix<int> cost(free.size(), vector<int>(window.size()));
+        matrix<pii> picks(free.size(), vector<pii>(window.size()));
+        for (var i = 0; i < (int)free.size(); i++) {
+            for (var j = 0; j < (int)window.size(); j++) {
+                std::tie(cost[i][j], picks[i][j]) = extraTravel(free[i], O.order[window[j]]);
+            }
+        }
+        val match = solveAssignment(cost, window.size());
+        for (var i = 0; i < (int)free.size(); i++) {
+            val j = match[i];
+            if (j == -1 || cost[i][j] == INT_SOFT_MAX) continue;
+            F.target[free[i]] = picks[i][j];
+            F.idle.reset(free[i]);
+            parked.erase(free[i]);
+            enRoute.erase(free[i]);
+            assign(window[j]);
+        }
+        while (O.nextAssignIndex != O.orders && O.assigned[O.nextAssignIndex]) O.nextAssignIndex++;
+    };
+    // online mode: every cfg.onlineSa ticks a background sa re-plans the pending orders, its latest plan goes first
+    // once there is one and the dispatcher serves the idle agvs it leaves; a streamed order asks for a new snapshot
+    // right away, until a plan covers it the dispatcher may hand it out
+    std::unique_ptr<OnlineSa> online;
+    if (cfg.onlineSa > 0) online = std::make_unique<OnlineSa>(G, cfg.capacity, cfg.onlineSaMs, state.rng());
+    var nextSnapshot = 0;
+    fun snapshot = [&]() {
+        SaSnapshot ret;
+        ret.tick = sim_clock;
+        for (var i = O.nextAssignIndex; i < O.orders; i++) {
+            if (O.assigned[i]) continue;
+            ret.orders.push_back(i);
+            ret.cells.push_back(O.order[i]);
+        }
+        // a busy agv starts over from sendArea once its current trip is done
+        for (var idx = 0; idx < agvs; idx++) {
+            val [r, c] = F.position[idx];
+            val [tr, tc] = F.target[idx];
+            if (F.target[idx] == F.restPosition[idx]) {
+                ret.starts.push_back(F.position[idx]);
+                ret.offsets.push_back(0);
+                continue;
+            }
+            var left = G.shortestPath(r, c, tr, tc);
+            if (F.target[idx] != sendArea) left += G.shortestPath(tr, tc, sendArea[0], sendArea[1]);
+            ret.starts.push_back(sendArea);
+            ret.offsets.push_back(left);
+        }
+        return ret;
+    };
+    // an idle agv takes the next order of its queue that is still pending, if it takes it at all
+    fun assignPlanned = [&](ref<SaPlan> plan) {
+        for (var idx = 0; idx < agvs; idx++) {
+            if (!F.idle.test(idx)) continue;
+            for (val id : plan.queue[idx]) {
+                if (O.assigned[id]) continue;
+                val [cost, pick] = extraTravel(idx, O.order[id]);
+                if (cost != INT_SOFT_MAX) {
+                    F.target[idx] = pick;
+                    F.idle.reset(idx);
+                    if (cfg.dispatch == Dispatch::Batch) {
+                        parked.erase(idx);
+                        enRoute.erase(idx);
+                    }
+                    assign(id);
+                }
+                break;
+            }
+        }
+        while (O.nextAssignIndex != O.orders && O.assigned[O.nextAssignIndex]) O.nextAssignIndex++;
+    };
+
+    // cooperative mode: agvs only ever walk their reserved plans, every agv holds one from the start
+    // plan[idx] begins at tick planFrom[idx] and was made for target planFor[idx]; an agv plans again, in agv order,
+    // for a new target or once less than half a window of a plan that falls short of the target is left
+    var &reservations = state.reservations;
+    var &planFrom = state.planFrom;
+    var &planFor = state.planFor;
+    // less than half of a window of 1 is never left, its plans would never be made again
+    val window = max(2, min(cfg.window, Reservations::MAX_WINDOW));
+    fun waiting = [&](int idx) { // holds its cell for the rest of its plan
+        val &plan = F.plan[idx];
+        val at = max(0, sim_clock - planFrom[idx]);
+        return at >= (int)plan.size() || std::all_of(plan.begin() + at, plan.end(), [&](pii v) {
+                   return v == F.position[idx];
+               });
+    };
+    fun replan = [&](int idx, int goal) {
+        F.plan[idx] = reservations.plan(G, cellId(F.position[idx]), goal, sim_clock, window);
+        planFrom[idx] = sim_clock;
+        planFor[idx] = F.target[idx];
+        reservations.reserve(F.plan[idx], G.cols, sim_clock, sim_clock);
+    };
+    // a stuck agv plans first and the waiting agvs on its direct path plan around it, or nothing changes
+    fun pushThrough = [&](int a) {
+        val [r, c] = F.position[a];
+        val [tr, tc] = F.target[a];
+        val direct = G.traceSimplePath(r, c, tr, tc);
+        vector<int> group = {a};
+        for (var i = 1; i < min((int)direct.size(), window + 1); i++) {
+            val b = holder[cellId(direct[i])];
+            if (b == -1 || F.position[b] != direct[i] || !waiting(b) || F.down.test(b)) continue;
+            group.push_back(b);
+        }
+        if (group.size() == 1) return false;
+        vector<vector<pii>> oldPlan;
+        vector<int> oldFrom;
+        for (val g : group) {
+            oldPlan.push_back(F.plan[g]);
+            oldFrom.push_back(planFrom[g]);
+            reservations.release(F.plan[g], G.cols, planFrom[g], sim_clock);
+            reservations.take(cellId(F.position[g]), sim_clock);
+        }
+        var planned = 0;
+        var ok = true;
+        for (; ok && planned < (int)group.size(); planned++) {
+            val g = group[planned];
+            reservations.expire(cellId(F.position[g]), sim_clock);
+            replan(g, cellId(F.target[g]));
+            ok = !F.plan[g].empty() && (planned > 0 || !waiting(g));
+        }
+        if (ok) return true;
+        // drop every new plan before restoring any old one, a later member may have planned over an earlier one's
+        for (var i = 0; i < (int)group.size(); i++) {
+            val g = group[i];
+            if (i >= planned) reservations.expire(cellId(F.position[g]), sim_clock);
+            else if (!F.plan[g].empty()) reservations.release(F.plan[g], G.cols, planFrom[g], sim_clock);
+        }
+        for (var i = 0; i < (int)group.size(); i++) {
+            val g = group[i];
+            F.plan[g] = oldPlan[i];
+            planFrom[g] = oldFrom[i];
+            planFor[g] = F.target[g];
+            reservations.reserve(F.plan[g], G.cols, planFrom[g], sim_clock);
+        }
+        return false;
+    };
+    fun moveCooperative = [&](int &tickReplans) {
+        for (var idx = 0; idx < agvs; idx++) {
+            val &plan = F.plan[idx];
+            val past = sim_clock - 1 - planFrom[idx];
+            if (past >= 0 && past < (int)plan.size()) reservations.expire(cellId(plan[past]), sim_clock - 1);
+        }
+        vector<int> stuck;
+        for (var idx = 0; idx < agvs; idx++) {
+            val &plan = F.plan[idx];
+            val at = min(sim_clock - planFrom[idx], (int)plan.size() - 1);
+            val fresh = planFor[idx] != F.target[idx];
+            val ending = plan.back() != F.target[idx] && (int)plan.size() - 1 - at < window / 2;
+            if (!F.moving(idx) || !(fresh || ending)) continue;
+            (fresh ? stats.plans : tickReplans)++;
+            reservations.release(plan, G.cols, planFrom[idx], sim_clock);
+            replan(idx, cellId(F.target[idx]));
+            if (waiting(idx)) stuck.push_back(idx);
+        }
+        // nowhere to go for a whole window, most likely others wait for this cell; make them move, or step aside
+        for (val idx : stuck) {
+            if (!waiting(idx) || pushThrough(idx)) continue;
+            reservations.release(F.plan[idx], G.cols, planFrom[idx], sim_clock);
+            val aside = reservations.plan(G, cellId(F.position[idx]), -1, sim_clock, window);
+            if (!aside.empty()) {
+                F.plan[idx] = aside;
+                planFrom[idx] = sim_clock;
+                stats.yields++;
+            }
+            reservations.reserve(F.plan[idx], G.cols, planFrom[idx], sim_clock);
+        }
+        // every step was reserved, the order agvs take them in does not matter
+        for (var idx = 0; idx < agvs; idx++) {
+            val &plan = F.plan[idx];
+            val next = sim_clock + 1 - planFrom[idx];
+            if (next >= (int)plan.size() || plan[next] == F.position[idx]) continue;
+            F.position[idx] = plan[next];
+            stats.moves++;
+        }
+    };
 
     loop {
+        if (cfg.eventDriven) {
+            val skip = quietTicks();
+            for (var k = 0; k < skip; k++) {
+                report();
+                for (var idx = 0; idx < agvs; idx++) {
+                    if (!F.moving(idx)) continue;
+                    F.position[idx] = F.plan[idx][++F.planAt[idx]];
+                    stats.moves++;
+                }
+            }
+            sim_clock += skip;
+            stats.skipped += skip;
+        }
         // limit clocks
-        if ((++sim_clock) > SIM_CLOCK_MAX) break;
+        if (sim_clock >= until) break;
+        sim_clock++;
+        Timer tickTimer;
+        PROFILE_BEGIN(profile);
+        // take in streamed orders
+        while (streamOpen && admit()) nextSnapshot = sim_clock;
         // report agvs
-        for (var idx = 0; idx < MAX_AGV; idx++) {
-            val &agv = agvs[idx];
-            paths[idx].push_back(agv.position);
-        }
-        // update blocks
-        set<pii> blocks;
-        for (val &agv : agvs) { blocks.insert(agv.position); }
-        // try to assign a task MAX_AGV times
-        // fetch all free agv index
-        vector<int> freeAgvIdx;
-        for (var idx = 0; idx < MAX_AGV; idx++) {
-            val agv = agvs[idx];
-            if (agv.target == agv.restPosition || agv.position == agv.restPosition ||
-                (agv.target == sendArea && agv.storage != MAX_AGV_TASK))
-                freeAgvIdx.push_back(idx);
+        report();
+#ifdef SIM_PROFILE
+        val reported = F.position;
+#endif
+        PROFILE_LAP(profile, Report);
+        // update blocks and the agvs that may take an order
+        blocks.clear();
+        for (var idx = 0; idx < agvs; idx++) {
+            blocks.set(cellId(F.position[idx]));
+            holder[cellId(F.position[idx])] = idx;
+            F.idle.assign(idx, F.mayTakeOrder(idx));
+            if (cfg.dispatch != Dispatch::Batch) continue;
+            if (F.idle.test(idx) && F.target[idx] == F.restPosition[idx]) {
+                parked.place(idx, F.position[idx]);
+            } else {
+                parked.erase(idx);
+            }
+            if (F.idle.test(idx) && F.target[idx] == sendArea && F.storage[idx] != F.capacity) {
+                enRoute.place(idx, F.position[idx]);
+            } else {
+                enRoute.erase(idx);
+            }
         }
+        PROFILE_LAP(profile, Blocks);
         // try to assign work
-        while (O.nextAssignIndex != MAX_ORDER) {
-            var succ = false;
-            pii task = O.order[O.nextAssignIndex];
-            for (var idx : freeAgvIdx) {
-                var &agv = agvs[idx];
-                // try to assign a work
-                auto [dis, dt] = G.argAdjMin(agv.position[0], agv.position[1], task[0], task[1]);
-                if (agv.target == sendArea) {
-                    val sDis = G.shortestPath(task[0] + dr[dt], task[1] + dc[dt], sendArea[0], sendArea[1]);
-                    val newDis = dis + sDis;
-                    val oldDis = G.shortestPath(agv.position[0], agv.position[1], sendArea[0], sendArea[1]) + 2 * sDis;
-                    if (newDis < oldDis) {
-                        agv.target = {task[0] + dr[dt], task[1] + dc[dt]};
-                        freeAgvIdx.erase(std::find(freeAgvIdx.begin(), freeAgvIdx.end(), agv.id));
-                        succ = true;
-                        O.nextAssignIndex++;
-                    }
-                    if (succ) break;
+        Timer dispatchTimer;
+        if (online && sim_clock >= nextSnapshot) {
+            online->submit(snapshot());
+            nextSnapshot = sim_clock + cfg.onlineSa;
+        }
+        if (val plan = online ? online->plan() : nullptr) assignPlanned(*plan);
+        // agvs still idle, with no plan yet or a queue that is used up, take what is pending from the dispatcher
+        if (cfg.dispatch == Dispatch::Batch) {
+            assignBatch();
+        } else {
+            // each order goes to the first idle agv that takes it
+            while (O.nextAssignIndex != O.orders) {
+                val taker = F.idle.findFirst([&](int idx) {
+                    val [cost, pick] = extraTravel(idx, O.order[O.nextAssignIndex]);
+                    if (cost == INT_SOFT_MAX) return false;
+                    F.target[idx] = pick;
+                    return true;
+                });
+                if (taker == -1) break;
+                F.idle.reset(taker);
+                assign(O.nextAssignIndex++);
+                if (F.idle.none()) break;
+            }
+        }
+        stats.dispatchMs += dispatchTimer.ms();
+        PROFILE_LAP(profile, Dispatch);
+        // move agvs
+        Timer moveTimer;
+        var tickReplans = 0;
+        if (cfg.planner == Planner::Cooperative) moveCooperative(tickReplans);
+        fun headOn = [&](int idx) {
+            val &plan = F.plan[idx];
+            val at = F.planAt[idx];
+            if (at + 1 >= (int)plan.size()) return false;
+            val other = holder[cellId(plan[at + 1])];
+            if (other == -1 || other >= idx || F.position[other] != plan[at + 1] || !F.moving(other)) return false;
+            val &otherPlan = F.plan[other];
+            val otherAt = F.planAt[other];
+            return otherAt + 1 < (int)otherPlan.size() && otherPlan[otherAt] == F.position[other] &&
+                   otherPlan[otherAt + 1] == F.position[idx];
+        };
+        for (var idx = 0; cfg.planner == Planner::Blocked && idx < agvs; idx++) {
+            if (!F.moving(idx)) continue;
+            fun taken = [&](pii v) { return blocks.test(cellId(v)); };
+            var &plan = F.plan[idx];
+            var &at = F.planAt[idx];
+            val fresh = plan.empty() || plan.back() != F.target[idx] || plan[at] != F.position[idx];
+            // the rest of the plan is a few bit tests, checking only the next cell walks agvs head-on into dead ends
+            // the goal itself may be taken, the agv then waits in front of it
+            // 0 if nothing is in the way, else a hash of the agv's cell and the taken cells
+            fun blockedAhead = [&]() {
+                uint64_t key = 0;
+                for (var i = at + 1; i + 1 < (int)plan.size(); i++) {
+                    if (taken(plan[i])) key = (key ^ cellId(plan[i])) * 1099511628211ULL + 1;
                 }
-                if (agv.target == agv.restPosition) {
-                    auto [dis, dt] = G.argAdjMin(agv.position[0], agv.position[1], task[0], task[1]);
-                    agv.target = {task[0] + dr[dt], task[1] + dc[dt]};
-                    freeAgvIdx.erase(std::find(freeAgvIdx.begin(), freeAgvIdx.end(), agv.id));
-                    succ = true;
-                    O.nextAssignIndex++;
-                    if (succ) break;
+                return key == 0 ? key : (key ^ cellId(F.position[idx])) * 1099511628211ULL | 1;
+            };
+            var stuck = !fresh && F.detour.test(idx);
+            if (!fresh && !stuck) {
+                // a queue behind a boxed-in agv would search the same way around every tick and find nothing again
+                // until it moves or the cells in its way change; a way around may open off the plan, so now and then
+                // the search is made anyway
+                val key = blockedAhead();
+                stuck = key != 0 && (key != F.waitKey[idx] || sim_clock >= F.retryAt[idx]);
+            }
+            if (fresh || stuck) {
+                (fresh ? stats.plans : tickReplans)++;
+                val [r, c] = F.position[idx];
+                val [tr, tc] = F.target[idx];
+                plan = G.traceBlockedPath(blocks, r, c, tr, tc);
+                at = 0;
+                F.waitKey[idx] = 0;
+                // boxed in, wait on the direct path so a head-on meeting can still be seen
+                if (plan.empty()) {
+                    plan = G.traceSimplePath(r, c, tr, tc);
+                    F.waitKey[idx] = blockedAhead();
+                    F.retryAt[idx] = sim_clock + RETRY_TICKS;
                 }
+                F.detour.assign(idx, (int)plan.size() - 1 > G.shortestPath(r, c, tr, tc));
             }
-            if (!succ || freeAgvIdx.empty()) break;
+            if (at + 1 < (int)plan.size() && !taken(plan[at + 1])) {
+                F.position[idx] = plan[++at];
+                stats.moves++;
+            } else if (headOn(idx)) {
+                // two agvs facing each other in a one-wide aisle, the later one steps aside and plans again
+                for (var i = 0; i < 4; i++) {
+                    val v = pii{F.position[idx][0] + dr[i], F.position[idx][1] + dc[i]};
+                    if (v[0] < 0 || v[0] >= G.rows || v[1] < 0 || v[1] >= G.cols) continue;
+                    if (!G.reachable(v[0], v[1]) || taken(v)) continue;
+                    F.position[idx] = v;
+                    plan.clear();
+                    stats.moves++;
+                    stats.yields++;
+                    break;
+                }
+            }
+            blocks.set(cellId(F.position[idx]));
+            holder[cellId(F.position[idx])] = idx;
         }
-        // move agvs
-        for (var idx = 0; idx < MAX_AGV; idx++) {
-            var &agv = agvs[idx];
-            if (agv.position == agv.target || agv.target == pii{0, 0}) continue;
-            val trace = G.traceBlockedPath(blocks, agv.position[0], agv.position[1], agv.target[0], agv.target[1]);
-            val nextPos = (trace.empty() || trace.size() == 1 ? agv.position : trace[1]);
-            agv.position = nextPos;
-            blocks.insert(nextPos);
+        stats.moveMs += moveTimer.ms();
+        stats.replans += tickReplans;
+        stats.maxReplans = max(stats.maxReplans, tickReplans);
+#ifdef SIM_PROFILE
+        // short of its target and still where it was reported
+        for (var idx = 0; idx < agvs; idx++) {
+            profile.tick[TickProfile::Stalled] += F.moving(idx) && F.position[idx] == reported[idx];
         }
+#endif
+        PROFILE_LAP(profile, Move);
         // check arrival of targe
-        for (var &agv : agvs) {
-            if (agv.position != agv.target) continue;
-            if (agv.target == agv.restPosition) continue;
-            if (agv.target == sendArea) {
-                agv.target = agv.restPosition;
-                agv.storage = 0;
+        for (var idx = 0; idx < agvs; idx++) {
+            if (F.position[idx] != F.target[idx]) continue;
+            if (F.target[idx] == F.restPosition[idx]) continue;
+            if (F.target[idx] == sendArea) {
+                F.target[idx] = F.restPosition[idx];
+                stats.delivered += F.storage[idx];
+                F.storage[idx] = 0;
             } else {
-                if (agv.target == agv.position) agv.storage++;
-                agv.target = sendArea;
+                F.storage[idx]++;
+                F.target[idx] = sendArea;
             }
         }
+        PROFILE_LAP(profile, Arrival);
+        PROFILE_END(profile);
+
+        stats.maxTickMs = max(stats.maxTickMs, tickTimer.ms());
+        // paced like a live system, which leaves the background search its time
+        if (cfg.tickMs > 0) {
+            std::this_thread::sleep_until(tickTimer.startTime + std::chrono::duration<double, std::milli>(cfg.tickMs));
+        }
 
         // break
-        if (O.nextAssignIndex == MAX_ORDER) {
+        if (O.nextAssignIndex == O.orders && !streamOpen) {
             var doneAgvs = 0;
-            for (val &agv : agvs) {
-                if (agv.position == agv.target) doneAgvs++;
-            }
-            if (doneAgvs == MAX_AGV) break;
+            for (var idx = 0; idx < agvs; idx++) doneAgvs += F.position[idx] == F.target[idx] || F.down.test(idx);
+            stats.finished = doneAgvs == agvs;
+            if (stats.finished) break;
         }
     }
-    DEBUG("final:");
-    DEBUG(sim_clock);
+    stats.ticks = sim_clock;
+    stats.ms += simTimer.ms();
+    std::sort(waits.begin(), waits.end());
+    std::sort(waitsMs.begin(), waitsMs.end());
+    if (!waits.empty()) {
+        val at = [&](double q) { return (size_t)(q * (waits.size() - 1)); };
+        stats.waitTicks = {waits[at(0.5)], waits[at(0.95)], waits.back()};
+        stats.waitMs = {waitsMs[at(0.5)], waitsMs[at(0.95)], waitsMs.back()};
+    }
+    if (stream) stats.rejected += stream->malformed;
+    if (online) {
+        stats.onlineRuns += online->runs;
+        stats.onlineImproved += online->improved;
+    }
+#ifdef SIM_PROFILE
+    TickProfile::current = nullptr;
+    if (!cfg.profileFile.empty() && !profile.write(cfg.profileFile)) cerr << "cannot write " << cfg.profileFile << endl;
+#endif
 
     // ouput paths
-    ofstream fout(greedy4simulate_path_file);
-    for (var idx = 0; idx < MAX_AGV; idx++) {
+    if (trajectory.isOpen() && !trajectory.close()) cerr << "cannot write " << cfg.pathFile << endl;
+    if (cfg.pathFile.empty() || isTrajectoryFile(cfg.pathFile)) return stats;
+    ofstream fout(cfg.pathFile);
+    for (var idx = 0; idx < agvs; idx++) {
         val &path = paths[idx];
         for (val p : path) { fout << p[0] << " " << p[1] << " "; }
         fout << endl;
     }
     fout.close();
+    return stats;
+}
+
+SimStats greedy4simulate(ref<Config> cfg) {
+    DEBUG("begin greedy4simulate");
+
+    GraphG G;
+    Order O;
+    if (!G.input(cfg.mapFile)) {
+        DEBUG("map file error");
+        return {};
+    }
+    {
+        Timer timer;
+        G.solveShortestPath(cfg.apspOptions());
+        DEBUG(timer.ms());
+    }
+    // a stream is read once, there is no greedy baseline over it
+    if (cfg.orderStream.empty()) O.input(cfg.orderFile, cfg.orders);
+    val stats = greedy4simulate(cfg, G, O);
+    if (cfg.orderStream.empty() && (cfg.dispatch != Dispatch::Greedy || cfg.onlineSa > 0)) {
+        var greedyCfg = cfg;
+        greedyCfg.dispatch = Dispatch::Greedy;
+        greedyCfg.onlineSa = 0;
+        greedyCfg.pathFile = "";
+        greedyCfg.profileFile = "";
+        val base = greedy4simulate(greedyCfg, G, O);
+        cerr << "dispatch " << (cfg.dispatch == Dispatch::Batch ? "batch" : "greedy");
+        if (cfg.dispatch == Dispatch::Batch) cerr << " lookahead=" << cfg.lookahead;
+        if (cfg.onlineSa > 0) cerr << " online-sa=" << cfg.onlineSa << "/" << cfg.onlineSaMs << "ms";
+        cerr << " ticks=" << stats.ticks << " moves=" << stats.moves << " finished=" << stats.finished
+             << " max tick ms=" << stats.maxTickMs << " | greedy ticks=" << base.ticks << " moves=" << base.moves
+             << " finished=" << base.finished << " max tick ms=" << base.maxTickMs << endl;
+    }
+    if (cfg.orderStream.empty() && cfg.planner == Planner::Cooperative) {
+        var blockedCfg = cfg;
+        blockedCfg.planner = Planner::Blocked;
+        blockedCfg.pathFile = "";
+        blockedCfg.profileFile = "";
+        val base = greedy4simulate(blockedCfg, G, O);
+        fun perTick = [](ref<SimStats> s) { return s.moveMs / max(1, s.ticks); };
+        cerr << "planner cooperative window=" << cfg.window << " ticks=" << stats.ticks << " moves=" << stats.moves
+             << " finished=" << stats.finished << " move ms/tick=" << perTick(stats)
+             << " | blocked ticks=" << base.ticks << " moves=" << base.moves << " finished=" << base.finished
+             << " move ms/tick=" << perTick(base) << endl;
+    }
+    if (!cfg.orderStream.empty()) {
+        cerr << "order stream " << cfg.orderStream << " delivered=" << stats.delivered << " rejected=" << stats.rejected
+             << " wait ticks p50/p95/max=" << stats.waitTicks[0] << "/" << stats.waitTicks[1] << "/"
+             << stats.waitTicks[2] << " wait ms p50/p95/max=" << stats.waitMs[0] << "/" << stats.waitMs[1] << "/"
+             << stats.waitMs[2] << endl;
+    }
+    if (cfg.onlineSa > 0) {
+        cerr << "online sa plans=" << stats.onlineRuns << " improved=" << stats.onlineImproved << endl;
+    }
+
+    DEBUG("final:");
+    DEBUG(stats.ticks);
+    cerr << "plans=" << stats.plans << " replans=" << stats.replans
+         << " replans/tick=" << (double)stats.replans / stats.ticks << " max replans/tick=" << stats.maxReplans
+         << " yields=" << stats.yields << endl;
+    if (cfg.eventDriven) {
+        cerr << "events arrival=" << stats.events[Event::Arrival] << " free=" << stats.events[Event::Free]
+             << " conflict=" << stats.events[Event::Conflict] << " order=" << stats.events[Event::Incoming]
+             << " ticks skipped=" << stats.skipped << "/" << stats.ticks << endl;
+    }
+    if (G.lazy.enabled()) G.lazy.report();
+    if (G.alt.enabled()) cerr << "alt landmarks=" << G.alt.count() << " bytes=" << G.alt.bytes() << endl;
 
     DEBUG("end greedy4simulate");
-}
\ No newline at end of file
+    return stats;
+}
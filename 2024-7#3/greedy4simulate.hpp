@@ -1,26 +1,102 @@
 #pragma once
 
+#include "assignment.hpp"
+#include "bitmap.hpp"
+#include "config.hpp"
 #include "graph.hpp"
+#include "onlineSa.hpp"
 #include "order.hpp"
+#include "orderStream.hpp"
+#include "reservation.hpp"
+#include "spatialIndex.hpp"
 #include "top.hpp"
 
 struct GraphG : Graph {
-    vector<pii> traceBlockedPath(ref<set<pii>> blocks, int fromR, int fromC, int toR, int toC) const;
+    vector<pii> traceBlockedPath(ref<Bitmap> blocks, int fromR, int fromC, int toR, int toC) const;
     pii argAdjMin(int fromR, int fromC, int toR, int toC) const; // return {dis, arg}
 };
 
 struct OrderG : Order {
-    int nextAssignIndex = 0;
+    int nextAssignIndex = 0;   // first order not handed out yet
+    vector<char> assigned = {}; // batch dispatch hands out orders past nextAssignIndex too
 };
 
-struct Agv {
-    pii position;
-    pii target;
-    pii restPosition;
-    int id;
-    int storage;
+// agv state as parallel arrays indexed by agv id, sized at runtime
+struct Fleet {
+    int size = 0;
+    int capacity = MAX_AGV_TASK; // orders carried before returning to sendArea
+    vector<pii> position;
+    vector<pii> target;
+    vector<pii> restPosition;
+    vector<int> storage;
+    vector<vector<pii>> plan; // cached path to target, followed until a cell on it is taken
+    vector<int> planAt;       // index of position in plan
+    Bitmap detour;            // plan goes around a taken cell, it is only kept for one step
+    vector<uint64_t> waitKey; // its cell and the taken cells on its plan when no way around was found, 0 if found
+    vector<int> retryAt;      // tick that search is made again even if neither changed
+    Bitmap idle;              // may take an order this tick
+    Bitmap down;              // broken down, it stays where it is and takes no orders
     //
-    void setPosition(int r, int c);
+    void init(ref<vector<pii>> rest, int capacity); // one agv parked on each rest cell
+    bool moving(int idx) const {
+        return position[idx] != target[idx] && target[idx] != pii{0, 0} && !down.test(idx);
+    }
+    bool mayTakeOrder(int idx) const; // at or heading to its rest cell, or heading to sendArea with room left
 };
 
-void greedy4simulate();
\ No newline at end of file
+struct SimStats {
+    int ticks = 0;
+    bool finished = false; // every order delivered and every agv parked within cfg.ticks
+    double ms = 0;         // simulation loop only
+    double dispatchMs = 0; // handing out orders, part of ms
+    double moveMs = 0;     // planning and stepping agvs, part of ms
+    double maxTickMs = 0;  // slowest full tick
+    int delivered = 0;     // orders dropped at sendArea
+    int64_t moves = 0;     // cells travelled by all agvs
+    int plans = 0;
+    int replans = 0;
+    int maxReplans = 0;           // in one tick
+    int yields = 0;               // steps aside from a head-on meeting
+    int skipped = 0;              // event mode
+    int onlineRuns = 0;           // background sa plans published
+    int onlineImproved = 0;       // of those, better than the plan they started from
+    array<int, 4> events = {};    // event mode, ticks ended by an arrival, a freed rest cell, a conflict or an order
+    int rejected = 0;             // streamed lines that are no order or name no rack next to a free cell
+    array<int, 3> waitTicks = {}; // from an order's arrival to its assignment: median, p95, max
+    array<double, 3> waitMs = {}; // the same in wall time, from when it was read or the run started
+};
+
+// everything a run carries from one tick to the next, made for one map, planner and fleet
+// it holds no per-tick history, so a copy is a cheap fork that goes on independently of the original
+struct SimState {
+    int clock = 0; // last simulated tick
+    Planner planner = Planner::Blocked;
+    Fleet F;
+    OrderG O;
+    SimStats stats;
+    vector<int> arrivedAt;  // per order, tick it became known
+    vector<int> waits;      // per assigned order, ticks from arrival to assignment
+    vector<double> waitsMs; // the same in wall time
+    mt19937 rng{42};        // seeds the background sa each time the run goes on
+    // cooperative planner
+    Reservations reservations;
+    vector<int> planFrom; // tick plan[idx] begins at
+    vector<pii> planFor;  // target plan[idx] was made for
+    //
+    bool init(ref<Config> cfg, ref<GraphG> G, ref<Order> orders); // tick 0, false if the map has too few 'P' cells
+    // a stopped agv is held where it is for the rest of the run; under the cooperative planner it first walks to the
+    // end of the plan it reserved
+    void breakDown(int idx) { F.down.set(idx); }
+    // checkpoint on disk, binary for the host that wrote it; it records the map, load takes it back on that map only
+    // and rejects a state with cells off the map's free cells or arrays sized for another fleet
+    bool save(ref<string> file, ref<Graph> G) const;
+    bool load(ref<string> file, ref<Graph> G);
+};
+
+// one run over a solved graph, neither is modified so runs on other threads can share them
+SimStats greedy4simulate(ref<Config> cfg, ref<GraphG> G, ref<Order> orders);
+// go on with `state` up to tick `until` or until it finishes; the path file gets the ticks of this call
+// streamed orders and the background sa only live within one call
+SimStats greedy4simulate(ref<Config> cfg, ref<GraphG> G, SimState &state, int until);
+// load cfg.mapFile and cfg.orderFile, solve and run once, reporting to cerr
+SimStats greedy4simulate(ref<Config> cfg);
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "../common/landmarks.hpp"
+#include "csr.hpp"
+#include "distTable.hpp"
+#include "top.hpp"
+
+// alt lower bounds for A* over Graph cells, rows and selection in common/landmarks.hpp
+struct Landmarks {
+    LandmarkRows rows;
+    //
+    bool enabled() const { return rows.enabled(); }
+    int count() const { return rows.cells.size(); }
+    size_t bytes() const { return rows.bytes(); }
+    // `remap` only needs its slot remap
+    void build(ref<Csr> graph, ref<DistTable> remap, int k) { rows.build(graph, remap.slotOf, remap.cellOf, k); }
+    // cell ids, INT_SOFT_MAX if the landmarks prove v unreachable from u
+    int bound(ref<DistTable> remap, int u, int v) const {
+        if (u == v) return 0;
+        val su = remap.slotOf[u], sv = remap.slotOf[v];
+        if (su < 0 || sv < 0) return INT_SOFT_MAX;
+        val d = rows.bound(su, sv);
+        return d < 0 ? INT_SOFT_MAX : d;
+    }
+};
@@ -0,0 +1,77 @@
+#include "lazyDist.hpp"
+
+void LazyDist::init(int s, size_t budgetBytes) {
+    slots = s;
+    maxRows = max<size_t>(1, budgetBytes / max<size_t>(1, slots * sizeof(int32_t)));
+    cache = std::make_shared<Cache>();
+}
+
+int LazyDist::get(ref<Csr> graph, ref<DistTable> remap, int u, int v) const {
+    if (u == v) return 0;
+    val su = remap.slotOf[u], sv = remap.slotOf[v];
+    if (su < 0 || sv < 0) return INT_SOFT_MAX;
+    std::lock_guard lock(cache->mtx);
+    var &rows = cache->rows;
+    var &order = cache->order;
+    fun touch = [&](int s) -> const vector<int32_t> * {
+        val it = rows.find(s);
+        if (it == rows.end()) return nullptr;
+        order.splice(order.begin(), order, it->second.first);
+        return &it->second.second;
+    };
+    // the table is symmetric, either endpoint's row answers; heuristics keep asking about the same goal
+    var row = touch(sv);
+    var other = su;
+    if (row == nullptr) {
+        row = touch(su);
+        other = sv;
+    }
+    if (row != nullptr) {
+        cache->hits++;
+    } else {
+        cache->misses++;
+        if (rows.size() >= maxRows) {
+            rows.erase(order.back());
+            order.pop_back();
+            cache->evictions++;
+        }
+        // bfs from the goal side
+        vector<int32_t> dis(remap.slots, -1);
+        vector<int> q = {remap.cellOf[sv]};
+        dis[sv] = 0;
+        for (size_t head = 0; head < q.size(); head++) {
+            val x = q[head];
+            val dx = dis[remap.slotOf[x]];
+            for (val y : graph[x]) {
+                var &dy = dis[remap.slotOf[y]];
+                if (dy != -1) continue;
+                dy = dx + 1;
+                q.push_back(y);
+            }
+        }
+        order.push_front(sv);
+        row = &(rows[sv] = make_pair(order.begin(), move(dis))).second;
+        other = su;
+    }
+    val d = (*row)[other];
+    return d < 0 ? INT_SOFT_MAX : d;
+}
+
+void LazyDist::clear() const {
+    std::lock_guard lock(cache->mtx);
+    cache->rows.clear();
+    cache->order.clear();
+}
+
+size_t LazyDist::bytes() const {
+    std::lock_guard lock(cache->mtx);
+    return cache->rows.size() * slots * sizeof(int32_t);
+}
+
+void LazyDist::report() const {
+    val held = bytes();
+    std::lock_guard lock(cache->mtx);
+    cerr << "lazy dist rows=" << cache->rows.size() << "/" << maxRows << " hits=" << cache->hits
+         << " misses=" << cache->misses << " evictions=" << cache->evictions << " bytes=" << held
+         << " budget=" << budget() << endl;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+#include "csr.hpp"
+#include "distTable.hpp"
+#include "top.hpp"
+
+// distance oracle for maps whose full table does not fit: a bfs row is computed the first time its cell is queried
+// and the most recently used rows are kept up to a byte budget, copies share one cache
+// rows are int32, lazy rows serve maps too big for the uint16 table, so their distances may not fit uint16 either
+struct LazyDist {
+    static constexpr size_t DEFAULT_BYTES = (size_t)256 << 20; // when rows are forced without a budget
+    //
+    struct Cache {
+        std::mutex mtx;
+        std::list<int> order; // slots, most recent first
+        std::unordered_map<int, pair<std::list<int>::iterator, vector<int32_t>>> rows; // -1 unreachable
+        size_t hits = 0, misses = 0, evictions = 0;
+    };
+    //
+    int slots = 0;
+    size_t maxRows = 0;
+    std::shared_ptr<Cache> cache;
+    //
+    bool enabled() const { return cache != nullptr; }
+    void init(int slots, size_t budgetBytes);
+    // cell ids, INT_SOFT_MAX if unreachable; `remap` only needs its slot remap
+    int get(ref<Csr> graph, ref<DistTable> remap, int u, int v) const;
+    void clear() const; // drop all rows, e.g. after the graph changed
+    size_t bytes() const; // rows held now
+    size_t budget() const { return maxRows * slots * sizeof(int32_t); }
+    void report() const;
+};
@@ -1,12 +1,259 @@
+#include <filesystem>
+
+#include "config.hpp"
 #include "greedy4simulate.hpp"
 #include "sa4lowerbound.hpp"
+#include "sweep.hpp"
+#include "threadPool.hpp"
+#include "trajectory.hpp"
+#include "whatIf.hpp"
+
+namespace {
+// time the all-pairs bfs per backend with 1, 2, 4, ... threads, then a load from the distance cache
+void benchApsp(ref<Config> cfg) {
+    const int REPEAT = 5;
+    Graph G;
+    if (!G.input(cfg.mapFile)) {
+        DEBUG("map file error");
+        return;
+    }
+    if (!G.solveShortestPath(1, ApspBackend::Queue)) {
+        cerr << "apsp: " << G.dist.slots << " cells do not fit a uint16 table" << endl;
+        return;
+    }
+    val maxThreads = resolveThreads(cfg.threads);
+    for (val &[backend, name] : {pair{ApspBackend::Queue, "queue"}, pair{ApspBackend::Bitboard, "bitboard"}}) {
+        for (var threads = 1;; threads = min(threads * 2, maxThreads)) {
+            var best = 1e18;
+            for (var i = 0; i < REPEAT; i++) {
+                Timer timer;
+                G.solveShortestPath(threads, backend);
+                best = min(best, timer.ms());
+            }
+            cerr << "apsp backend=" << name << " threads=" << threads << " nodes=" << G.nodes
+                 << " slots=" << G.dist.slots << " bytes=" << G.dist.bytes() << " ms=" << best << endl;
+            if (threads == maxThreads) break;
+        }
+    }
+    // both backends must agree entry for entry
+    G.solveShortestPath(1, ApspBackend::Queue);
+    val expect = G.dist;
+    G.solveShortestPath(1, ApspBackend::Bitboard);
+    val same = std::equal(expect.data, expect.data + expect.entries, G.dist.data);
+    cerr << "apsp backends agree=" << same << endl;
+    if (cfg.distCache.empty()) return;
+    var options = cfg.apspOptions();
+    options.budgetBytes = 0;
+    G.solveShortestPath(options); // make sure the cache exists
+    var best = 1e18;
+    for (var i = 0; i < REPEAT; i++) {
+        Timer timer;
+        G.solveShortestPath(options);
+        best = min(best, timer.ms());
+    }
+    cerr << "apsp cached file=" << cfg.distCache << " ms=" << best << endl;
+}
+
+// A* expansions and memory with the exact table against alt bounds from 1, 2, 4, ... landmarks
+void benchAlt(ref<Config> cfg) {
+    const int QUERIES = 2000;
+    const int MAX_LANDMARKS = 32;
+    Graph G;
+    if (!G.input(cfg.mapFile)) {
+        DEBUG("map file error");
+        return;
+    }
+    var options = cfg.apspOptions();
+    options.landmarks = 0;
+    G.solveShortestPath(options);
+    mt19937 mt(42);
+    uniform_int_distribution<int> randSlot(0, G.dist.slots - 1);
+    vector<pii> queries(QUERIES);
+    for (var &[u, v] : queries) u = G.dist.cellOf[randSlot(mt)], v = G.dist.cellOf[randSlot(mt)];
+    // bytes after the queries, lazy rows are only held once asked for
+    fun run = [&](ref<string> name, auto bytes) {
+        var expanded = 0, found = 0;
+        Timer timer;
+        for (val &[u, v] : queries) {
+            found += !G.searchPath(u, v, [](int) { return false; }, G.nodes, &expanded).empty();
+        }
+        cerr << "alt heuristic=" << name << " bytes=" << bytes() << " expanded/query=" << (double)expanded / QUERIES
+             << " found=" << found << " us/query=" << timer.ms() * 1000 / QUERIES << endl;
+    };
+    run("exact", [&]() { return G.lazy.enabled() ? G.lazy.bytes() : G.dist.bytes(); });
+    for (var k = 1; k <= MAX_LANDMARKS; k *= 2) {
+        G.alt.build(G.graph, G.dist, k);
+        run("landmarks-" + std::to_string(k), [&]() { return G.alt.bytes(); });
+    }
+}
+
+// close then reopen random free cells, timing the repair against a full solve and checking it against one
+void benchBlock(ref<Config> cfg) {
+    const int TRIALS = 50;
+    Graph G;
+    if (!G.input(cfg.mapFile)) {
+        DEBUG("map file error");
+        return;
+    }
+    var options = cfg.apspOptions();
+    options.cacheFile = "";
+    options.budgetBytes = 0;
+    options.landmarks = 0;
+    Timer timer;
+    G.solveShortestPath(options);
+    cerr << "block full solve ms=" << timer.ms() << " entries=" << G.dist.entries << endl;
+    mt19937 mt(42);
+    val cells = G.dist.cellOf;
+    uniform_int_distribution<int> randCell(0, (int)cells.size() - 1);
+    for (val blocked : {true, false}) {
+        var touched = (size_t)0, mismatches = (size_t)0;
+        var ms = 0.0;
+        mt.seed(42);
+        for (var t = 0; t < TRIALS; t++) {
+            val [r, c] = id2v(cells[randCell(mt)], G.cols);
+            if (!blocked) G.setBlocked(r, c, true);
+            timer.reset();
+            touched += G.setBlocked(r, c, blocked);
+            ms += timer.ms();
+            var fresh = G;
+            fresh.solveShortestPath(options);
+            for (var u = 0; u < G.nodes; u++) {
+                for (var v = 0; v < G.nodes; v++) mismatches += G.distance(u, v) != fresh.distance(u, v);
+            }
+            if (blocked) G.setBlocked(r, c, false);
+        }
+        cerr << "block " << (blocked ? "close" : "reopen") << " entries/op=" << (double)touched / TRIALS
+             << " ms/op=" << ms / TRIALS << " mismatches=" << mismatches << endl;
+    }
+}
 
-int main() {
+// trip-partition dp evaluations per second, walking every trip again against growing trips incrementally, over random
+// task sequences of the map's racks
+void benchTrip(ref<Config> cfg) {
+    const double MIN_MS = 200; // per engine and length
+    Graph G;
+    if (!G.input(cfg.mapFile)) {
+        DEBUG("map file error");
+        return;
+    }
+    G.solveShortestPath(cfg.apspOptions());
+    Order O;
+    O.generate(G.grid, 1000, OrderMix::Uniform, 42);
+    if (O.orders == 0 || G.parking.empty()) return;
+    val start = G.parking[0];
+    for (val length : {5, 25, 100, 400}) {
+        vector<pii> task(O.order.begin(), O.order.begin() + min(length, O.orders));
+        var mismatches = 0;
+        for (var k = 0; k < length; k++) {
+            std::rotate(task.begin(), task.begin() + 1, task.end());
+            mismatches += tripCost(G, start, task, cfg.capacity) != tripCostReference(G, start, task, cfg.capacity);
+        }
+        fun rate = [&](auto engine) {
+            var evals = 0;
+            [[maybe_unused]] volatile double sink; // every result is stored, so no call is optimised away
+            Timer timer;
+            while (timer.ms() < MIN_MS) {
+                for (var k = 0; k < 16; k++, evals++) sink = engine(G, start, task, cfg.capacity);
+            }
+            return evals / timer.ms() * 1000;
+        };
+        val before = rate(tripCostReference), after = rate(tripCost);
+        cerr << "trip length=" << task.size() << " capacity=" << cfg.capacity << " evals/s reference=" << before
+             << " incremental=" << after << " speedup=" << after / before << " mismatches=" << mismatches << endl;
+    }
+}
+
+// tick cost of greedy4simulate for growing fleets on a generated warehouse with a 'P' cell for every agv
+void benchFleet(ref<Config> cfg) {
+    const int WIDTH = 66;
+    const int MAX_FLEET = 2000;
+    const int TICKS = 200;
+    const int ORDERS = 4 * MAX_FLEET;
+    // bands of two rack rows, an aisle, a parking row and an aisle; sendArea is on the aisle of the third band
+    val bands = max(3, (MAX_FLEET + WIDTH - 1) / WIDTH);
+    matrix<char> grid;
+    for (var b = 0; b < bands; b++) {
+        for (val kind : {'X', 'X', 'o', 'P', 'o'}) {
+            grid.emplace_back(WIDTH, kind);
+            if (kind == 'X') {
+                for (var c = 0; c < WIDTH; c += 7) grid.back()[c] = 'o';
+            }
+        }
+    }
+    val dir = std::filesystem::temp_directory_path();
+    var fleetCfg = cfg;
+    fleetCfg.mapFile = dir / "fleet_map.txt";
+    fleetCfg.orderFile = dir / "fleet_order.txt";
+    fleetCfg.pathFile = dir / "fleet_path.txt";
+    fleetCfg.profileFile = "";
+    fleetCfg.orderStream = "";
+    fleetCfg.distCache = cfg.distCache.empty() ? "" : string(dir / "fleet_map.dist");
+    fleetCfg.ticks = TICKS;
+    {
+        ofstream fout(fleetCfg.mapFile);
+        for (val &row : grid) fout << string(row.begin(), row.end()) << endl;
+    }
+    {
+        Order O;
+        O.generate(grid, ORDERS, OrderMix::Uniform, 42);
+        ofstream fout(fleetCfg.orderFile);
+        for (val &[r, c] : O.order) fout << r << " " << c << endl;
+    }
+    for (val agvs : {4, 16, 64, 250, 500, 1000, 2000}) {
+        fleetCfg.agvs = agvs;
+        fleetCfg.orders = 4 * agvs;
+        val stats = greedy4simulate(fleetCfg);
+        cerr << "fleet agvs=" << agvs << " ticks=" << stats.ticks << " plans=" << stats.plans
+             << " replans=" << stats.replans << " ms=" << stats.ms << " ms/tick=" << stats.ms / max(1, stats.ticks)
+             << " dispatch ms/tick=" << stats.dispatchMs / max(1, stats.ticks)
+             << " move ms/tick=" << stats.moveMs / max(1, stats.ticks) << endl;
+    }
+}
+} // namespace
+
+int main(int argc, char **argv) {
     DEBUG("main");
 
-    sa4lowerbound();
-    greedy4simulate();
+    Config cfg;
+    if (!cfg.parse(argc, argv)) return 1;
+
+    if (cfg.benchApsp) {
+        benchApsp(cfg);
+        return 0;
+    }
+    if (cfg.benchAlt) {
+        benchAlt(cfg);
+        return 0;
+    }
+    if (cfg.benchBlock) {
+        benchBlock(cfg);
+        return 0;
+    }
+    if (cfg.benchTrip) {
+        benchTrip(cfg);
+        return 0;
+    }
+    if (cfg.benchFleet) {
+        benchFleet(cfg);
+        return 0;
+    }
+    if (!cfg.sweepFile.empty()) {
+        sweep(cfg);
+        return 0;
+    }
+    if (cfg.forkAt > 0 || !cfg.resume.empty()) {
+        whatIf(cfg);
+        return 0;
+    }
+    if (!cfg.trajToText.empty()) {
+        if (trajectory2Text(cfg.trajToText, cout)) return 0;
+        cerr << "cannot read trajectory " << cfg.trajToText << endl;
+        return 1;
+    }
+
+    sa4lowerbound(cfg);
+    greedy4simulate(cfg);
 
     DEBUG("all end");
     return 0;
-}
\ No newline at end of file
+}
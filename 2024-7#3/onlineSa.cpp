@@ -0,0 +1,147 @@
+#include "onlineSa.hpp"
+
+#include <cmath>
+
+#include "sa4lowerbound.hpp"
+
+OnlineSa::OnlineSa(ref<Graph> G, int capacity, double budgetMs, uint32_t seed)
+    : G(G), capacity(capacity), budgetMs(budgetMs), mt(seed) {
+    worker = std::thread([this]() {
+        loop {
+            std::unique_ptr<SaSnapshot> snapshot;
+            {
+                std::unique_lock lock(mtx);
+                ready.wait(lock, [this]() { return stopping || next != nullptr; });
+                if (stopping) return;
+                snapshot = move(next);
+            }
+            val warm = published.load();
+            published.store(std::make_shared<const SaPlan>(search(*snapshot, warm.get())));
+            runs++;
+        }
+    });
+}
+
+OnlineSa::~OnlineSa() {
+    {
+        std::lock_guard lock(mtx);
+        stopping = true;
+    }
+    ready.notify_all();
+    worker.join();
+}
+
+void OnlineSa::submit(SaSnapshot snapshot) {
+    {
+        std::lock_guard lock(mtx);
+        next = std::make_unique<SaSnapshot>(move(snapshot));
+    }
+    ready.notify_one();
+}
+
+SaPlan OnlineSa::search(ref<SaSnapshot> snapshot, const SaPlan *warm) {
+    const double TOTAL_WEIGHT = 1e-3; // the busiest agv decides, total travel breaks ties
+    const double T_INIT_RATIO = 0.05; // of the starting cost
+    const double T_END_RATIO = 1e-3;  // of the initial temperature
+    Timer timer;
+    val agvs = (int)snapshot.starts.size();
+    val n = (int)snapshot.orders.size();
+    SaPlan ret;
+    ret.tick = snapshot.tick;
+    ret.agvOf.assign(n == 0 ? 0 : snapshot.orders.back() + 1, -1); // ids are ascending
+    ret.queue.assign(agvs, {});
+    if (n == 0 || agvs == 0) return ret;
+
+    // start from the last plan where it still applies, new orders go to the agv that reaches them first
+    vector<int> agvOf(n);
+    fun reach = [&](int a, pii cell) {
+        var best = INT_SOFT_MAX;
+        for (var d = 0; d < 4; d++) {
+            val r = cell[0] + dr[d], c = cell[1] + dc[d];
+            if (r < 0 || r >= G.rows || c < 0 || c >= G.cols || !G.reachable(r, c)) continue;
+            best = min(best, G.shortestPath(snapshot.starts[a][0], snapshot.starts[a][1], r, c));
+        }
+        return best;
+    };
+    for (var i = 0; i < n; i++) {
+        val id = snapshot.orders[i];
+        if (warm != nullptr && id < (int)warm->agvOf.size() && warm->agvOf[id] != -1 && warm->agvOf[id] < agvs) {
+            agvOf[i] = warm->agvOf[id];
+            continue;
+        }
+        var best = INT_SOFT_MAX;
+        for (var a = 0; a < agvs; a++) {
+            val d = reach(a, snapshot.cells[i]) + snapshot.offsets[a];
+            if (d >= best) continue;
+            best = d;
+            agvOf[i] = a;
+        }
+    }
+    // orders of each agv stay sorted by snapshot position, the sequence the simulator takes them in
+    matrix<int> members(agvs);
+    for (var i = 0; i < n; i++) members[agvOf[i]].push_back(i);
+    fun travel = [&](int a) {
+        vector<pii> task;
+        for (val i : members[a]) task.push_back(snapshot.cells[i]);
+        return snapshot.offsets[a] + tripCost(G, snapshot.starts[a], task, capacity);
+    };
+    vector<double> cost(agvs);
+    for (var a = 0; a < agvs; a++) cost[a] = travel(a);
+    fun objective = [&]() {
+        var mx = 0.0, sum = 0.0;
+        for (val c : cost) mx = max(mx, c), sum += c;
+        return mx + sum * TOTAL_WEIGHT;
+    };
+
+    var now = objective();
+    val initial = now;
+    var best = now;
+    var bestAgvOf = agvOf;
+    val tInit = max(1.0, now * T_INIT_RATIO);
+    var t = tInit;
+    uniform_int_distribution<int> randOrder(0, n - 1);
+    uniform_int_distribution<int> randAgv(0, agvs - 1);
+    uniform_real_distribution<double> rand01(0, 1);
+    fun reassign = [&](int i, int from, int to) {
+        var &src = members[from];
+        src.erase(std::find(src.begin(), src.end(), i));
+        var &dst = members[to];
+        dst.insert(std::lower_bound(dst.begin(), dst.end(), i), i);
+        agvOf[i] = to;
+    };
+    for (var iter = 0; agvs > 1; iter++) {
+        if (iter % 32 == 0) {
+            val progress = timer.ms() / budgetMs;
+            if (progress >= 1) break;
+            t = tInit * std::pow(T_END_RATIO, progress);
+        }
+        val i = randOrder(mt);
+        val from = agvOf[i];
+        val to = randAgv(mt);
+        if (to == from) continue;
+        val oldFrom = cost[from], oldTo = cost[to];
+        reassign(i, from, to);
+        cost[from] = travel(from);
+        cost[to] = travel(to);
+        val moved = objective();
+        if (moved <= now || std::exp((now - moved) / t) > rand01(mt)) {
+            now = moved;
+            if (now < best) {
+                best = now;
+                bestAgvOf = agvOf;
+            }
+        } else {
+            reassign(i, to, from);
+            cost[from] = oldFrom;
+            cost[to] = oldTo;
+        }
+    }
+    if (warm != nullptr && best < initial) improved++;
+
+    for (var i = 0; i < n; i++) {
+        ret.agvOf[snapshot.orders[i]] = bestAgvOf[i];
+        ret.queue[bestAgvOf[i]].push_back(snapshot.orders[i]);
+    }
+    ret.cost = best;
+    return ret;
+}
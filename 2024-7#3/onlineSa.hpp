@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "graph.hpp"
+#include "top.hpp"
+
+// what the simulator knows when it asks for a plan
+struct SaSnapshot {
+    int tick = 0;
+    vector<int> orders;  // pending order ids
+    vector<pii> cells;   // their racks
+    vector<pii> starts;  // per agv, where its next trip begins
+    vector<int> offsets; // per agv, travel left before that
+};
+
+// agv of each pending order, and the orders of each agv in the sequence it should take them
+struct SaPlan {
+    int tick = 0;      // of the snapshot it was made from
+    vector<int> agvOf; // per order id, -1 if not planned
+    matrix<int> queue; // per agv, order ids
+    double cost = 0;   // busiest agv's travel
+};
+
+// rolling-horizon re-optimisation: a background thread runs a time-boxed sa over the latest snapshot and publishes
+// the plan; the simulator only hands a snapshot over and loads a pointer, it never waits for the search
+struct OnlineSa {
+    ref<Graph> G;
+    int capacity;
+    double budgetMs;
+    mt19937 mt;
+    std::atomic<std::shared_ptr<const SaPlan>> published;
+    std::atomic<int> runs = 0;
+    std::atomic<int> improved = 0; // runs that beat the plan they started from
+    //
+    std::mutex mtx;
+    std::condition_variable ready;
+    std::unique_ptr<SaSnapshot> next; // not started yet, a newer one replaces it
+    bool stopping = false;
+    std::thread worker;
+    //
+    OnlineSa(ref<Graph> G, int capacity, double budgetMs, uint32_t seed);
+    OnlineSa(const OnlineSa &) = delete;
+    OnlineSa &operator=(const OnlineSa &) = delete;
+    ~OnlineSa();
+    //
+    void submit(SaSnapshot snapshot);
+    std::shared_ptr<const SaPlan> plan() const { return published.load(); }
+    SaPlan search(ref<SaSnapshot> snapshot, const SaPlan *warm);
+};
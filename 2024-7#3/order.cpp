@@ -1,15 +1,45 @@
 #include "order.hpp"
 
 
-bool Order::input(string filename) {
+bool Order::input(string filename, int limit) {
     {
         // input order
         ifstream fin(filename);
         if (!fin) return false;
         int row, col;
-        while (fin >> row >> col) { order.push_back({row, col}); }
+        while ((limit < 0 || (int)order.size() < limit) && fin >> row >> col) { order.push_back({row, col}); }
         fin.close();
     }
     orders = order.size();
     return true;
-}
\ No newline at end of file
+}
+
+void Order::generate(ref<matrix<char>> grid, int count, OrderMix mix, uint32_t seed) {
+    const double HOT_SHARE = 0.8;
+    const int HOT_PART = 5; // one rack in HOT_PART is hot
+    vector<pii> racks;
+    fun free = [&](int r, int c) {
+        return r >= 0 && r < (int)grid.size() && c >= 0 && c < (int)grid[r].size() &&
+               (grid[r][c] == 'o' || grid[r][c] == 'P');
+    };
+    for (var r = 0; r < (int)grid.size(); r++) {
+        for (var c = 0; c < (int)grid[r].size(); c++) {
+            if (grid[r][c] != 'X') continue;
+            if (free(r - 1, c) || free(r + 1, c) || free(r, c - 1) || free(r, c + 1)) racks.push_back({r, c});
+        }
+    }
+    order.clear();
+    orders = 0;
+    if (racks.empty()) return;
+    mt19937 mt(seed);
+    std::shuffle(racks.begin(), racks.end(), mt);
+    val hot = max(1, (int)racks.size() / HOT_PART);
+    uniform_int_distribution<int> randRack(0, (int)racks.size() - 1);
+    uniform_int_distribution<int> randHot(0, hot - 1);
+    uniform_real_distribution<double> rand01(0, 1);
+    for (var i = 0; i < count; i++) {
+        val isHot = mix == OrderMix::Hot && rand01(mt) < HOT_SHARE;
+        order.push_back(racks[isHot ? randHot(mt) : randRack(mt)]);
+    }
+    orders = order.size();
+}
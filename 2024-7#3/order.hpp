@@ -2,9 +2,14 @@
 
 #include "top.hpp"
 
+// where generated orders fall: every rack alike, or 80% of them on a fixed fifth of the racks
+enum class OrderMix { Uniform, Hot };
+
 struct Order {
     vector<pii> order;
-    int orders;
+    int orders = 0;
     //
-    bool input(string filename);
+    bool input(string filename, int limit = -1); // at most `limit` orders, -1 for all
+    // `count` orders on racks, 'X' cells next to a free one
+    void generate(ref<matrix<char>> grid, int count, OrderMix mix, uint32_t seed);
 };
@@ -0,0 +1,113 @@
+// system headers first, they must not see the var/val macros from top.hpp
+#include <cerrno>
+#include <cstdio>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "orderStream.hpp"
+
+OrderStream::OrderStream(string source, size_t capacity, bool follow)
+    : source(move(source)), follow(follow), queue(capacity) {
+    reader = std::thread([this]() {
+        read();
+        closed = true;
+    });
+}
+
+OrderStream::~OrderStream() {
+    stopping = true;
+    reader.join();
+}
+
+bool OrderStream::line(ref<string> text) {
+    if (text.find_first_not_of(" \t\r") == string::npos) return true;
+    if (text.rfind("end", 0) == 0) return false;
+    int a, b, c;
+    char extra;
+    val n = std::sscanf(text.c_str(), "%d %d %d %c", &a, &b, &c, &extra);
+    StreamedOrder order;
+    if (n == 2) {
+        order.cell = {a, b};
+    } else if (n == 3) {
+        order.tick = a;
+        order.cell = {b, c};
+    } else {
+        malformed++;
+        return true;
+    }
+    order.readAt = std::chrono::steady_clock::now();
+    // full, the simulation is behind
+    while (!queue.push(order)) {
+        if (stopping) return false;
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    return true;
+}
+
+void OrderStream::read() {
+    const int POLL_MS = 10;
+#ifndef _WIN32
+    // non-blocking, so opening a fifo without a writer does not keep the reader from stopping; stdin is shared with
+    // whoever started us and stays as it is, so reads wait for poll to report input or its end
+    val fd = source == "-" ? STDIN_FILENO : open(source.c_str(), O_RDONLY | O_NONBLOCK);
+    if (fd < 0) {
+        cerr << "cannot open order stream " << source << endl;
+        return;
+    }
+    struct stat st;
+    val fifo = fstat(fd, &st) == 0 && S_ISFIFO(st.st_mode);
+    string pending;
+    var seen = false; // a fifo reads as ended until its first writer shows up
+    char buffer[4096];
+    while (!stopping) {
+        pollfd p = {fd, POLLIN, 0};
+        val ready = poll(&p, 1, POLL_MS);
+        if (ready < 0 && errno != EINTR) break;
+        if (ready <= 0) continue;
+        val n = ::read(fd, buffer, sizeof(buffer));
+        if (n < 0) {
+            if (errno != EAGAIN && errno != EINTR) break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(POLL_MS));
+            continue;
+        }
+        if (n == 0) {
+            if (!follow && (!fifo || seen)) break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(POLL_MS));
+            continue;
+        }
+        seen = true;
+        pending.append(buffer, n);
+        size_t from = 0;
+        for (var to = pending.find('\n'); to != string::npos; to = pending.find('\n', from)) {
+            if (!line(pending.substr(from, to - from))) {
+                if (fd != STDIN_FILENO) close(fd);
+                return;
+            }
+            from = to + 1;
+        }
+        pending.erase(0, from);
+    }
+    if (!stopping) line(pending);
+    if (fd != STDIN_FILENO) close(fd);
+#else
+    // blocking reads, the reader only notices stopping between lines
+    ifstream file;
+    if (source != "-") file.open(source);
+    std::istream &in = source == "-" ? std::cin : file;
+    string text;
+    while (!stopping) {
+        if (std::getline(in, text)) {
+            if (!line(text)) return;
+            continue;
+        }
+        if (!follow) return;
+        in.clear();
+        std::this_thread::sleep_for(std::chrono::milliseconds(POLL_MS));
+    }
+#endif
+}
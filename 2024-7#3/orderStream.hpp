@@ -0,0 +1,35 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+
+#include "spscQueue.hpp"
+#include "top.hpp"
+
+struct StreamedOrder {
+    int tick = 0; // earliest tick it may be handed out, 0 -> as soon as it is read
+    pii cell = {};
+    std::chrono::steady_clock::time_point readAt = {}; // wall time the reader parsed it
+};
+
+// orders that arrive while the simulation runs: from stdin ("-"), a fifo or a file, one "[tick] row col" per line
+// a reader thread parses them into a bounded queue that the simulation drains every tick; when the queue is full the
+// reader waits, so it runs at most a queue ahead of the simulation
+struct OrderStream {
+    string source;
+    bool follow; // at the end of the input keep polling for more until an "end" line
+    SpscQueue<StreamedOrder> queue;
+    std::atomic<bool> closed = false; // nothing more will be pushed
+    std::atomic<bool> stopping = false;
+    std::atomic<int> malformed = 0; // lines that are not an order
+    std::thread reader;
+    //
+    OrderStream(string source, size_t capacity, bool follow);
+    OrderStream(const OrderStream &) = delete;
+    OrderStream &operator=(const OrderStream &) = delete;
+    ~OrderStream();
+    //
+    bool pop(StreamedOrder &out) { return queue.pop(out); }
+    void read();                 // reader thread
+    bool line(ref<string> text); // parse and push one line, false on "end"
+};
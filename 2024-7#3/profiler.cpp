@@ -0,0 +1,40 @@
+#include "profiler.hpp"
+
+thread_local TickProfile *TickProfile::current = nullptr;
+
+int64_t Histogram::quantile(double q) const {
+    if (count == 0) return 0;
+    val rank = (int64_t)(q * (count - 1));
+    int64_t seen = 0;
+    for (var i = 0; i < BUCKETS; i++) {
+        seen += buckets[i];
+        if (seen > rank) return i == 0 ? 0 : std::min(max, (int64_t)1 << i);
+    }
+    return max;
+}
+
+bool TickProfile::write(ref<string> file) const {
+    ofstream fout(file);
+    if (!fout) return false;
+    fun histogram = [&](ref<Histogram> h) {
+        var last = Histogram::BUCKETS - 1;
+        while (last > 0 && h.buckets[last] == 0) last--;
+        fout << "{\"count\": " << h.count << ", \"sum\": " << h.sum << ", \"max\": " << h.max
+             << ", \"p50\": " << h.quantile(0.5) << ", \"p99\": " << h.quantile(0.99) << ", \"log2_buckets\": [";
+        for (var i = 0; i <= last; i++) fout << (i ? ", " : "") << h.buckets[i];
+        fout << "]}";
+    };
+    // phases in ns, counters per tick; bucket i of log2_buckets counts values below 2^i and at least 2^(i-1)
+    fout << "{\n  \"ticks\": " << phaseNs[Report].count << ",\n  \"phase_ns\": {";
+    for (var i = 0; i < PHASES; i++) {
+        fout << (i ? "," : "") << "\n    \"" << PHASE_NAMES[i] << "\": ";
+        histogram(phaseNs[i]);
+    }
+    fout << "\n  },\n  \"counters\": {";
+    for (var i = 0; i < COUNTERS; i++) {
+        fout << (i ? "," : "") << "\n    \"" << COUNTER_NAMES[i] << "\": ";
+        histogram(counts[i]);
+    }
+    fout << "\n  }\n}" << endl;
+    return (bool)fout;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+
+#include "top.hpp"
+
+// per-tick phase times and counters of greedy4simulate, kept only in builds with -DSIM_PROFILE
+// without it every PROFILE_ macro expands to nothing and no clock is read; with it a tick reads the clock once per
+// phase and a search bumps a thread-local counter
+
+// log2 buckets, so a run of any length keeps a fixed size: bucket 0 counts zeros, bucket i values in [2^(i-1), 2^i)
+struct Histogram {
+    static constexpr int BUCKETS = 48;
+    //
+    int64_t count = 0, sum = 0, max = 0;
+    array<int64_t, BUCKETS> buckets = {};
+    //
+    void add(int64_t v) {
+        count++;
+        sum += v;
+        max = std::max(max, v);
+        buckets[min<int>(std::bit_width((uint64_t)v), BUCKETS - 1)]++;
+    }
+    int64_t quantile(double q) const; // upper bound of the bucket holding it
+};
+
+struct TickProfile {
+    enum Phase { Report, Blocks, Dispatch, Move, Arrival, PHASES };
+    enum Counter { Searches, Expanded, DispatchTries, Stalled, COUNTERS };
+    static constexpr const char *PHASE_NAMES[PHASES] = {"report", "blocks", "dispatch", "move", "arrival"};
+    static constexpr const char *COUNTER_NAMES[COUNTERS] = {"searches", "expanded", "dispatch_tries", "stalled"};
+    //
+    array<Histogram, PHASES> phaseNs;     // per full tick
+    array<Histogram, COUNTERS> counts;    // per full tick
+    array<int64_t, COUNTERS> tick = {};   // counted so far this tick
+    std::chrono::steady_clock::time_point lapAt;
+    //
+    void begin() { lapAt = std::chrono::steady_clock::now(); }
+    void lap(Phase phase) { // time since the last lap goes to phase
+        val now = std::chrono::steady_clock::now();
+        phaseNs[phase].add(std::chrono::duration_cast<std::chrono::nanoseconds>(now - lapAt).count());
+        lapAt = now;
+    }
+    void end() { // this tick's counters go into their histograms
+        for (var i = 0; i < COUNTERS; i++) counts[i].add(tick[i]);
+        tick = {};
+    }
+    bool write(ref<string> file) const; // json
+    // the profile of the run on this thread, shared code such as graph searches counts into it
+    static thread_local TickProfile *current;
+};
+
+#ifdef SIM_PROFILE
+#define PROFILE_BEGIN(PROFILE) (PROFILE).begin()
+#define PROFILE_LAP(PROFILE, PHASE) (PROFILE).lap(TickProfile::PHASE)
+#define PROFILE_END(PROFILE) (PROFILE).end()
+#define PROFILE_COUNT(COUNTER, N)                                                                                      \
+    do {                                                                                                               \
+        if (TickProfile::current != nullptr) TickProfile::current->tick[TickProfile::COUNTER] += (N);                  \
+    } while (0)
+#else
+#define PROFILE_BEGIN(PROFILE) ((void)0)
+#define PROFILE_LAP(PROFILE, PHASE) ((void)0)
+#define PROFILE_END(PROFILE) ((void)0)
+#define PROFILE_COUNT(COUNTER, N) ((void)0)
+#endif
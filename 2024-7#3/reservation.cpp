@@ -0,0 +1,68 @@
+#include "reservation.hpp"
+
+#include "profiler.hpp"
+
+void Reservations::init(int nodes) {
+    bits.assign(nodes, 0);
+    heldFrom.assign(nodes, INT_SOFT_MAX);
+}
+
+void Reservations::reserve(ref<vector<pii>> path, int cols, int from, int since) {
+    if (path.empty()) return;
+    for (var i = max(0, since - from); i < (int)path.size(); i++) {
+        bits[v2id(path[i][0], path[i][1], cols)] |= span(from + i, 1);
+    }
+    heldFrom[v2id(path.back()[0], path.back()[1], cols)] = from + path.size() - 1;
+}
+
+void Reservations::release(ref<vector<pii>> path, int cols, int from, int since) {
+    if (path.empty()) return;
+    for (var i = max(0, since - from); i < (int)path.size(); i++) {
+        bits[v2id(path[i][0], path[i][1], cols)] &= ~span(from + i, 1);
+    }
+    heldFrom[v2id(path.back()[0], path.back()[1], cols)] = INT_SOFT_MAX;
+}
+
+vector<pii> Reservations::plan(ref<Graph> G, int from, int goal, int now, int window) {
+    val layers = window + 1;
+    if ((int)seen.size() != G.nodes * layers) {
+        seen.assign(G.nodes * layers, 0);
+        pre.assign(G.nodes * layers, -1);
+        stamp = 0;
+    }
+    stamp++;
+    // {f, -dt, state}, deeper first among equal f
+    priority_queue<array<int, 3>, vector<array<int, 3>>, std::greater<array<int, 3>>> q;
+    fun h = [&](int u) { return goal == -1 ? 0 : G.heuristic(u, goal); };
+    val start = from * layers;
+    seen[start] = stamp;
+    pre[start] = -1;
+    q.push({h(from), 0, start});
+    var end = -1;
+    PROFILE_COUNT(Searches, 1);
+    while (!q.empty()) {
+        val [f, negDt, state] = q.top();
+        q.pop();
+        PROFILE_COUNT(Expanded, 1);
+        val u = state / layers, dt = -negDt;
+        val done = goal == -1 ? u != from : u == goal || dt == window;
+        if (done && holdable(u, now + dt, now)) {
+            end = state;
+            break;
+        }
+        if (dt == window || (goal == -1 && u != from)) continue;
+        fun push = [&](int v) {
+            val next = v * layers + dt + 1;
+            if (seen[next] == stamp || !free(v, now + dt + 1)) return;
+            seen[next] = stamp;
+            pre[next] = state;
+            q.push({dt + 1 + h(v), -(dt + 1), next});
+        };
+        push(u);
+        for (val v : G.graph[u]) push(v);
+    }
+    vector<pii> ret;
+    for (var state = end; state != -1; state = pre[state]) ret.push_back(id2v(state / layers, G.cols));
+    reverse(ret.begin(), ret.end());
+    return ret;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+
+#include "graph.hpp"
+#include "top.hpp"
+
+// space-time reservation table for cooperative planning, flat over cells: a ring of tick bits per cell, and the tick
+// from which an agv stays on it for good
+// a cell taken at tick t is kept from everyone else from t - 1 to t + 1, so reserved moves never meet in a cell, swap
+// or step into a cell the tick it is left; every agv always holds a path and the cell at its end, so keeping the old
+// path is a valid plan and a search under the table cannot fail
+struct Reservations {
+    static constexpr int SLOTS = 64;                 // ticks in the ring, from the current one - 1 on
+    static constexpr int MAX_WINDOW = SLOTS / 2 - 2; // planned ticks ahead
+    //
+    vector<uint64_t> bits; // per cell, bit t % SLOTS is set if some agv is on it at tick t
+    vector<int> heldFrom;  // per cell, INT_SOFT_MAX if nobody stays
+    vector<int> seen, pre; // search scratch over cell * (window + 1) + dt, `stamp` marks this search's entries
+    int stamp = 0;
+    //
+    void init(int nodes);
+    // path[i] is taken at tick from + i, its last cell from then on; ticks before `since` are past and left out,
+    // their ring bits may already stand for ticks ahead
+    void reserve(ref<vector<pii>> path, int cols, int from, int since);
+    void release(ref<vector<pii>> path, int cols, int from, int since);
+    void take(int cell, int tick) { bits[cell] |= span(tick, 1); }
+    void expire(int cell, int tick) { bits[cell] &= ~span(tick, 1); } // the owner is past it
+    bool free(int cell, int tick) const { return !(bits[cell] & span(tick - 1, 3)) && heldFrom[cell] > tick + 1; }
+    // free for good from tick on, as seen from now
+    bool holdable(int cell, int tick, int now) const {
+        return heldFrom[cell] == INT_SOFT_MAX && !(bits[cell] & ~span(now - 1, tick - now));
+    }
+    // windowed cooperative A*: the cheapest cell sequence from `from` at tick now, one per tick and waits included,
+    // that ends on `goal` or after `window` ticks on a cell it can hold, counting distance to `goal` from there
+    // with `goal` -1 it is the quickest way off `from` to a cell it can hold instead
+    // empty if there is none, which only happens if the caller holds nothing or steps aside
+    vector<pii> plan(ref<Graph> G, int from, int goal, int now, int window);
+    //
+    static uint64_t span(int tick, int count) { // ring bits of count ticks from tick on
+        if (count <= 0) return 0;
+        return std::rotl(count >= SLOTS ? ~0ULL : (1ULL << count) - 1, ((tick % SLOTS) + SLOTS) % SLOTS);
+    }
+};
@@ -1,7 +1,10 @@
 #include "sa4lowerbound.hpp"
 
+#include "trajectory.hpp"
+
 namespace {
-int argAdjMin(ref<Graph> G, int fromR, int fromC, int toR, int toC) {
+// {distance, neighbour} of the neighbour of `to` closest to `from`, the first one on ties
+pii adjMin(ref<Graph> G, int fromR, int fromC, int toR, int toC) {
     int mn = INT_SOFT_MAX, argMn = 0;
     for (var i = 0; i < 4; i++) {
         int tr = toR + dr[i], tc = toC + dc[i];
@@ -12,80 +15,55 @@ int argAdjMin(ref<Graph> G, int fromR, int fromC, int toR, int toC) {
             argMn = i;
         }
     }
-    return argMn;
+    return {mn, argMn};
 }
+int argAdjMin(ref<Graph> G, int fromR, int fromC, int toR, int toC) { return adjMin(G, fromR, fromC, toR, toC)[1]; }
 
-double dp(ref<Graph> G, ref<Order> O, ref<vector<int>> schedule) {
-    fun cost = [&](ref<vector<pii>> task, int from, int to) {
-        var ret = 0.0;
-        var lastR = sendArea[0];
-        var lastC = sendArea[1];
-        for (var i = from; i <= to; i++) {
-            val r = task[i][0], c = task[i][1];
-            val argMn = argAdjMin(G, lastR, lastC, r, c);
-            ret += G.shortestPath(lastR, lastC, r + dr[argMn], c + dc[argMn]);
-            lastR = r + dr[argMn];
-            lastC = c + dc[argMn];
-        }
-        ret += G.shortestPath(lastR, lastC, sendArea[0], sendArea[1]);
-        return ret;
-    };
-    //
+// one trip from sendArea through task[from..to] and back
+double segmentCost(ref<Graph> G, ref<vector<pii>> task, int from, int to) {
+    var ret = 0.0;
+    var lastR = sendArea[0];
+    var lastC = sendArea[1];
+    for (var i = from; i <= to; i++) {
+        val r = task[i][0], c = task[i][1];
+        val argMn = argAdjMin(G, lastR, lastC, r, c);
+        ret += G.shortestPath(lastR, lastC, r + dr[argMn], c + dc[argMn]);
+        lastR = r + dr[argMn];
+        lastC = c + dc[argMn];
+    }
+    ret += G.shortestPath(lastR, lastC, sendArea[0], sendArea[1]);
+    return ret;
+}
+
+// full recompute over the whole schedule, the sa keeps it per agv and only checks against this with -DSA_CHECK_COST
+[[maybe_unused]] double dp(ref<Graph> G, ref<Order> O, ref<vector<pii>> rest, ref<vector<int>> schedule, int capacity) {
     var ret = 0;
-    for (var idx = 0; idx < MAX_AGV; idx++) {
+    for (var idx = 0; idx < (int)rest.size(); idx++) {
         vector<pii> task;
         for (var i = 0; i < schedule.size(); i++) {
             val agv = schedule[i];
             if (agv == idx) task.push_back(O.order[i]);
         }
         if (task.empty()) continue;
-        // dp
-        vector<double> f(task.size(), INT_SOFT_MAX);
-        for (int i = 0; i < 4; i++) {
-            int tr = task[0][0] + dr[i], tc = task[0][1] + dc[i];
-            f[0] = min(f[0], G.shortestPath(agvRestArea[idx][0], agvRestArea[idx][1], tr, tc) +
-                                 G.shortestPath(tr, tc, sendArea[0], sendArea[1]) * 1.0);
-        }
-        for (var i = 1; i < task.size(); i++) {
-            for (var j = i; j > 0 && i - j < MAX_AGV_TASK; j--) {
-                double c = cost(task, j, i);
-                f[i] = min(f[i], f[j - 1] + c);
-            }
-        }
-        ret += f.back();
+        ret += tripCost(G, rest[idx], task, capacity);
     }
     return ret;
 }
 
-void convert2path(ref<Graph> G, ref<Order> O, ref<vector<int>> schedule) {
-    fun cost = [&](ref<vector<pii>> task, int from, int to) {
-        var ret = 0.0;
-        var lastR = sendArea[0];
-        var lastC = sendArea[1];
-        for (var i = from; i <= to; i++) {
-            val r = task[i][0], c = task[i][1];
-            val argMn = argAdjMin(G, lastR, lastC, r, c);
-            ret += G.shortestPath(lastR, lastC, r + dr[argMn], c + dc[argMn]);
-            lastR = r + dr[argMn];
-            lastC = c + dc[argMn];
-        }
-        ret += G.shortestPath(lastR, lastC, sendArea[0], sendArea[1]);
-        return ret;
-    };
+void convert2path(ref<Graph> G, ref<Order> O, ref<vector<pii>> rest, ref<vector<int>> schedule, int capacity,
+                  ref<string> file) {
     fun getPath = [&](pii from, pii to) {
         val argMn = argAdjMin(G, from[0], from[1], to[0], to[1]);
         val goalR = to[0] + dr[argMn], goalC = to[1] + dc[argMn];
         return make_pair(pii{goalR, goalC}, G.traceSimplePath(from[0], from[1], goalR, goalC));
     };
-    // create a empty file
-    {
-        ofstream fout(sa4lowerbound_path_file);
-        if (!fout) DEBUG("create file error");
-        fout.close();
-    }
-    //
-    ofstream fout(sa4lowerbound_path_file, std::ios::app);
-    for (var idx = 0; idx < MAX_AGV; idx++) {
+    // a text file gets each path as it is made, a trajectory is written per tick so it needs all of them
+    val binary = isTrajectoryFile(file);
+    ofstream fout;
+    if (!binary) fout.open(file);
+    if (!binary && !fout) DEBUG("create file error");
+    matrix<pii> paths;
+    for (var idx = 0; idx < (int)rest.size(); idx++) {
         vector<pii> task;
         for (var i = 0; i < schedule.size(); i++) {
             val agv = schedule[i];
@@ -93,23 +71,7 @@ void convert2path(ref<Graph> G, ref<Order> O, ref<vector<int>> schedule) {
         }
         if (task.empty()) continue;
         // dp
-        vector<double> f(task.size(), INT_SOFT_MAX);
-        vector<int> last(task.size(), 0);
-        for (int i = 0; i < 4; i++) {
-            int tr = task[0][0] + dr[i], tc = task[0][1] + dc[i];
-            f[0] = min(f[0], G.shortestPath(agvRestArea[idx][0], agvRestArea[idx][1], tr, tc) +
-                                 G.shortestPath(tr, tc, sendArea[0], sendArea[1]) * 1.0);
-        }
-        for (var i = 1; i < task.size(); i++) {
-            for (var j = i; j > 0 && i - j < MAX_AGV_TASK; j--) {
-                double c = cost(task, j, i);
-                // f[i] = min(f[i], f[j - 1] + c);
-                if (f[i] > f[j - 1] + c) {
-                    f[i] = f[j - 1] + c;
-                    last[i] = j - 1;
-                }
-            }
-        }
+        val last = tripPlan(G, rest[idx], task, capacity).last;
         // convert task to route
         vector<pii> route;
         {
@@ -122,10 +84,10 @@ void convert2path(ref<Graph> G, ref<Order> O, ref<vector<int>> schedule) {
                 p = last[p];
             }
             while (head >= 0) { route.push_back(task[head--]); }
-            route.push_back(agvRestArea[idx]);
+            route.push_back(rest[idx]);
         }
         reverse(route.begin(), route.end());
-        route.push_back(agvRestArea[0]);
+        route.push_back(rest[0]);
         // convert route to path
         vector<pii> path;
         {
@@ -138,14 +100,89 @@ void convert2path(ref<Graph> G, ref<Order> O, ref<vector<int>> schedule) {
             }
         }
         // output
+        if (binary) {
+            paths.push_back(move(path));
+            continue;
+        }
         for (val v : path) { fout << v[0] << " " << v[1] << " "; }
-        fout << endl;
+        fout << "\n";
     }
-    fout.close();
+    if (binary && !writeTrajectory(file, G.rows, G.cols, paths)) DEBUG("create file error");
 }
 } // namespace
 
-void sa4lowerbound() {
+TripPlan tripPlan(ref<Graph> G, pii start, ref<vector<pii>> task, int capacity) {
+    TripPlan ret;
+    val n = (int)task.size();
+    if (n == 0) return ret;
+    var &f = ret.f;
+    var &last = ret.last;
+    f.assign(n, INT_SOFT_MAX);
+    last.assign(n, 0);
+    for (int i = 0; i < 4; i++) {
+        int tr = task[0][0] + dr[i], tc = task[0][1] + dc[i];
+        f[0] = min(f[0], G.shortestPath(start[0], start[1], tr, tc) +
+                             G.shortestPath(tr, tc, sendArea[0], sendArea[1]) * 1.0);
+    }
+    // where a trip picks task[k] from only depends on where it picked task[k - 1] from, or on sendArea for its first
+    // pick; each such step and way back is looked up the first time a trip needs it, -1 until then
+    thread_local vector<pii> first, next; // {distance, neighbour} per pick, and per pick and neighbour before
+    thread_local vector<int> back;        // to sendArea per pick and neighbour
+    first.assign(n, {-1, 0});
+    next.assign(n * 4, {-1, 0});
+    back.assign(n * 4, -1);
+    fun stepFrom = [&](int k, int from) { // to task[k] from neighbour `from` of task[k - 1], -1 -> sendArea
+        var &s = from == -1 ? first[k] : next[k * 4 + from];
+        if (s[0] == -1) {
+            val [r, c] = from == -1 ? sendArea : pii{task[k - 1][0] + dr[from], task[k - 1][1] + dc[from]};
+            s = adjMin(G, r, c, task[k][0], task[k][1]);
+        }
+        return s;
+    };
+    fun backFrom = [&](int k, int at) {
+        var &b = back[k * 4 + at];
+        if (b == -1) b = G.shortestPath(task[k][0] + dr[at], task[k][1] + dc[at], sendArea[0], sendArea[1]);
+        return b;
+    };
+    // trips task[j..i] grow one pick at a time from each start j, f[j - 1] is final once every earlier start is done;
+    // on ties the later start wins, as with the trips ending at i tried from the latest start down
+    for (var j = 1; j < n; j++) {
+        var walk = 0.0;
+        var at = -1;
+        for (var i = j; i < n && i - j < capacity; i++) {
+            val [d, arg] = stepFrom(i, at);
+            walk += d;
+            at = arg;
+            val c = f[j - 1] + walk + backFrom(i, at);
+            if (c <= f[i]) {
+                f[i] = c;
+                last[i] = j - 1;
+            }
+        }
+    }
+    return ret;
+}
+
+double tripCost(ref<Graph> G, pii start, ref<vector<pii>> task, int capacity) {
+    if (task.empty()) return 0;
+    return tripPlan(G, start, task, capacity).f.back();
+}
+
+double tripCostReference(ref<Graph> G, pii start, ref<vector<pii>> task, int capacity) {
+    if (task.empty()) return 0;
+    vector<double> f(task.size(), INT_SOFT_MAX);
+    for (int i = 0; i < 4; i++) {
+        int tr = task[0][0] + dr[i], tc = task[0][1] + dc[i];
+        f[0] = min(f[0], G.shortestPath(start[0], start[1], tr, tc) +
+                             G.shortestPath(tr, tc, sendArea[0], sendArea[1]) * 1.0);
+    }
+    for (var i = 1; i < (int)task.size(); i++) {
+        for (var j = i; j > 0 && i - j < capacity; j--) f[i] = min(f[i], f[j - 1] + segmentCost(G, task, j, i));
+    }
+    return f.back();
+}
+
+void sa4lowerbound(ref<Config> cfg) {
     DEBUG("begin sa4lowerbound");
 
     // constants
@@ -160,13 +197,47 @@ void sa4lowerbound() {
     Order O;
 
     // init
-    G.input(map_file);
-    G.solveShortestPath();
-    O.input(order_file);
+    if (!G.input(cfg.mapFile)) {
+        DEBUG("map file error");
+        return;
+    }
+    {
+        Timer timer;
+        G.solveShortestPath(cfg.apspOptions());
+        DEBUG(timer.ms());
+    }
+    O.input(cfg.orderFile, cfg.orders);
+    if ((int)G.parking.size() < cfg.agvs) {
+        cerr << "map has " << G.parking.size() << " 'P' cells for " << cfg.agvs << " agvs" << endl;
+        return;
+    }
+    val rest = vector<pii>(G.parking.begin(), G.parking.begin() + cfg.agvs);
 
     // sa
-    fun evaluate = [&](ref<vector<int>> schedule) { return dp(G, O, schedule); };
-    uniform_int_distribution<int> randAgv(0, MAX_AGV - 1);
+    // a move hands one order to another agv, so only the two agvs it touches are costed again
+    // members[a] keeps a's order ids ascending, the sequence it serves them in
+    matrix<int> members(cfg.agvs);
+    vector<double> cost(cfg.agvs);
+    var total = 0.0;
+    fun travel = [&](int a) {
+        vector<pii> task;
+        for (val i : members[a]) task.push_back(O.order[i]);
+        return tripCost(G, rest[a], task, cfg.capacity);
+    };
+    fun evaluate = [&](ref<vector<int>> schedule) {
+        for (var &m : members) m.clear();
+        for (var i = 0; i < O.orders; i++) members[schedule[i]].push_back(i);
+        total = 0;
+        for (var a = 0; a < cfg.agvs; a++) total += cost[a] = travel(a);
+        return total;
+    };
+    fun reassign = [&](int i, int from, int to) {
+        var &src = members[from];
+        src.erase(std::lower_bound(src.begin(), src.end(), i));
+        var &dst = members[to];
+        dst.insert(std::lower_bound(dst.begin(), dst.end(), i), i);
+    };
+    uniform_int_distribution<int> randAgv(0, cfg.agvs - 1);
     uniform_int_distribution<int> randOrder(0, O.orders - 1);
     uniform_real_distribution<double> rand01(0, 1);
 
@@ -182,15 +253,33 @@ void sa4lowerbound() {
             val pos = randOrder(mt);
             val redo = schedule[pos];
             schedule[pos] = randAgv(mt);
-            val nowAns = evaluate(schedule);
+            val to = schedule[pos];
+            val oldFrom = cost[redo], oldTo = cost[to];
+            if (to != redo) {
+                reassign(pos, redo, to);
+                cost[redo] = travel(redo);
+                cost[to] = travel(to);
+            }
+            val nowAns = total - oldFrom - oldTo + cost[redo] + cost[to];
+#ifdef SA_CHECK_COST
+            if (std::abs(nowAns - dp(G, O, rest, schedule, cfg.capacity)) > eps) {
+                DEBUG("cost cache out of sync");
+                std::abort();
+            }
+#endif
             val delta = nowAns - bestAns;
             if (delta < 0 || exp(-delta / t) > rand01(mt)) {
-                bestAns = nowAns;
+                total = bestAns = nowAns;
                 if (nowAns < gBsetAns) {
                     gBsetAns = nowAns;
                     gBestSchedule = schedule;
                 }
             } else {
+                if (to != redo) {
+                    reassign(pos, to, redo);
+                    cost[redo] = oldFrom;
+                    cost[to] = oldTo;
+                }
                 schedule[pos] = redo;
             }
             t *= SA_DELTA_T;
@@ -209,7 +298,8 @@ void sa4lowerbound() {
     fout.close();
 
     DEBUG("output path");
-    convert2path(G, O, gBestSchedule);
+    convert2path(G, O, rest, gBestSchedule, cfg.capacity, cfg.saPathFile);
+    if (G.lazy.enabled()) G.lazy.report();
 
     DEBUG("end sa4lowerbound");
 }
\ No newline at end of file
@@ -1,7 +1,20 @@
 #pragma once
 
+#include "config.hpp"
 #include "graph.hpp"
 #include "order.hpp"
 #include "top.hpp"
 
-void sa4lowerbound();
\ No newline at end of file
+// the dp that sa4lowerbound sums over agvs: one agv from `start` serves `task` in sequence, the first order on its own
+// and the rest in trips of at most `capacity` orders from and back to sendArea, each rack picked from its neighbour
+// closest to the previous pick; O(n * capacity) steps and O(n) distance lookups
+struct TripPlan {
+    vector<double> f; // travel to serve task[0..i]
+    vector<int> last; // the last trip of f[i] starts at task[last[i] + 1]
+};
+TripPlan tripPlan(ref<Graph> G, pii start, ref<vector<pii>> task, int capacity);
+double tripCost(ref<Graph> G, pii start, ref<vector<pii>> task, int capacity); // tripPlan(...).f.back(), 0 if empty
+// the same walking every trip again from its first pick, O(n * capacity^2) lookups; checks and benchmarks only
+double tripCostReference(ref<Graph> G, pii start, ref<vector<pii>> task, int capacity);
+
+void sa4lowerbound(ref<Config> cfg);
\ No newline at end of file
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "top.hpp"
+
+// ids on grid cells, bucketed by square blocks of cells; place and erase are O(1)
+// nearest() visits blocks in rings around a cell, so only the blocks that can still hold a closer id are looked at
+struct SpatialIndex {
+    int block = 8;
+    int blockRows = 0, blockCols = 0;
+    vector<vector<int>> buckets; // ids per block, unordered
+    vector<int> bucketOf;        // block of each id, -1 if absent
+    vector<int> slot;            // index of each id in its bucket
+    int count = 0;
+    //
+    void init(int rows, int cols, int ids, int block = 8) {
+        this->block = block;
+        blockRows = (rows + block - 1) / block;
+        blockCols = (cols + block - 1) / block;
+        buckets.assign(blockRows * blockCols, {});
+        bucketOf.assign(ids, -1);
+        slot.assign(ids, 0);
+        count = 0;
+    }
+    int size() const { return count; }
+    bool contains(int id) const { return bucketOf[id] != -1; }
+    void erase(int id) {
+        val b = bucketOf[id];
+        if (b == -1) return;
+        var &bucket = buckets[b];
+        val last = bucket.back();
+        bucket[slot[id]] = last;
+        slot[last] = slot[id];
+        bucket.pop_back();
+        bucketOf[id] = -1;
+        count--;
+    }
+    void place(int id, pii cell) { // insert, or move if present
+        val b = cell[0] / block * blockCols + cell[1] / block;
+        if (bucketOf[id] == b) return;
+        erase(id);
+        bucketOf[id] = b;
+        slot[id] = buckets[b].size();
+        buckets[b].push_back(id);
+        count++;
+    }
+    // up to k ids with the smallest dist(id) as {dist, id}, closest first; dist(id) must be at least the manhattan
+    // distance from `cell` to the id's cell minus one, ids with dist >= INT_SOFT_MAX are left out
+    template <typename F> vector<pii> nearest(pii cell, int k, F &&dist) const {
+        vector<pii> best; // max-heap of the k closest so far
+        k = min(k, count);
+        if (k <= 0) return best;
+        val br = cell[0] / block, bc = cell[1] / block;
+        val maxRing = max({br, bc, blockRows - 1 - br, blockCols - 1 - bc});
+        fun visit = [&](int r, int c) {
+            if (r < 0 || r >= blockRows || c < 0 || c >= blockCols) return;
+            for (val id : buckets[r * blockCols + c]) {
+                val d = dist(id);
+                if (d >= INT_SOFT_MAX || ((int)best.size() == k && d >= best.front()[0])) continue;
+                best.push_back({d, id});
+                std::push_heap(best.begin(), best.end());
+                if ((int)best.size() > k) {
+                    std::pop_heap(best.begin(), best.end());
+                    best.pop_back();
+                }
+            }
+        };
+        for (var ring = 0; ring <= maxRing; ring++) {
+            // every cell of a block in this ring is at least (ring - 1) * block + 1 cells away
+            if ((int)best.size() == k && best.front()[0] <= (ring - 1) * block) break;
+            for (var c = bc - ring; c <= bc + ring; c++) {
+                visit(br - ring, c);
+                if (ring > 0) visit(br + ring, c);
+            }
+            for (var r = br - ring + 1; r < br + ring; r++) {
+                visit(r, bc - ring);
+                visit(r, bc + ring);
+            }
+        }
+        std::sort_heap(best.begin(), best.end());
+        return best;
+    }
+};
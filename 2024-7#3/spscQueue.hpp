@@ -0,0 +1,34 @@
+#pragma once
+
+#include <atomic>
+
+#include "top.hpp"
+
+// bounded ring between one producer and one consumer thread, neither side locks or waits
+// head and tail only grow, a slot is their value modulo the power-of-two capacity
+template <typename T> struct SpscQueue {
+    vector<T> slots;
+    size_t mask;
+    alignas(64) std::atomic<size_t> head = 0; // next to pop, only the consumer writes it
+    alignas(64) std::atomic<size_t> tail = 0; // next to push, only the producer writes it
+    //
+    explicit SpscQueue(size_t capacity) : slots(std::bit_ceil(max<size_t>(capacity, 1))), mask(slots.size() - 1) {}
+    SpscQueue(const SpscQueue &) = delete;
+    SpscQueue &operator=(const SpscQueue &) = delete;
+    //
+    size_t capacity() const { return slots.size(); }
+    bool push(T value) { // false if full
+        val t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == slots.size()) return false;
+        slots[t & mask] = move(value);
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+    bool pop(T &out) { // false if empty
+        val h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) return false;
+        out = move(slots[h & mask]);
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+};
@@ -0,0 +1,103 @@
+#include "sweep.hpp"
+
+#include <cmath>
+
+#include "greedy4simulate.hpp"
+#include "threadPool.hpp"
+
+namespace {
+const double SECONDS_PER_TICK = 1.0; // an agv crosses one cell per tick
+
+struct Run {
+    int agvs;
+    int capacity;
+    int mix;
+    int seed;
+    SimStats stats;
+};
+} // namespace
+
+void sweep(ref<Config> cfg) {
+    DEBUG("begin sweep");
+
+    GraphG G;
+    if (!G.input(cfg.mapFile)) {
+        DEBUG("map file error");
+        return;
+    }
+    {
+        Timer timer;
+        G.solveShortestPath(cfg.apspOptions());
+        DEBUG(timer.ms());
+    }
+
+    // every fleet size and capacity sees the same order sets, rows then differ only in the parameters
+    const array mixes = {pair{OrderMix::Uniform, "uniform"}, pair{OrderMix::Hot, "hot"}};
+    matrix<Order> orderSets(mixes.size(), vector<Order>(cfg.sweepSeeds));
+    for (var m = 0; m < (int)mixes.size(); m++) {
+        for (var seed = 0; seed < cfg.sweepSeeds; seed++) {
+            orderSets[m][seed].generate(G.grid, cfg.orders, mixes[m].first, seed + 1);
+        }
+    }
+    vector<Run> runs;
+    for (val agvs : cfg.sweepAgvs) {
+        if (agvs > (int)G.parking.size()) {
+            cerr << "skip agvs=" << agvs << ", map has " << G.parking.size() << " 'P' cells" << endl;
+            continue;
+        }
+        for (val capacity : cfg.sweepCapacity) {
+            for (var m = 0; m < (int)mixes.size(); m++) {
+                for (var seed = 0; seed < cfg.sweepSeeds; seed++) runs.push_back({agvs, capacity, m, seed, {}});
+            }
+        }
+    }
+
+    ThreadPool pool(cfg.threads);
+    Timer wall;
+    pool.parallelFor(runs.size(), [&](int i) {
+        var &run = runs[i];
+        var runCfg = cfg;
+        runCfg.agvs = run.agvs;
+        runCfg.capacity = run.capacity;
+        runCfg.pathFile = "";
+        runCfg.profileFile = "";
+        runCfg.orderStream = "";
+        run.stats = greedy4simulate(runCfg, G, orderSets[run.mix][run.seed]);
+    });
+    val wallMs = wall.ms();
+
+    // runs of one combination are consecutive, one per seed
+    ofstream fout(cfg.sweepFile);
+    fout << "dispatch,agvs,capacity,mix,runs,finished,makespan_mean,makespan_sd,makespan_max,moves_per_order,"
+            "orders_per_hour,replans_per_tick"
+         << endl;
+    val dispatch = cfg.dispatch == Dispatch::Batch ? "batch" : "greedy";
+    var serialMs = 0.0;
+    for (size_t from = 0; from < runs.size(); from += cfg.sweepSeeds) {
+        val &first = runs[from];
+        var finished = 0, delivered = 0, replans = 0, makespanMax = 0;
+        var ticks = 0.0, ticks2 = 0.0, moves = 0.0;
+        for (var i = from; i < from + cfg.sweepSeeds; i++) {
+            val &stats = runs[i].stats;
+            finished += stats.finished;
+            delivered += stats.delivered;
+            replans += stats.replans;
+            makespanMax = max(makespanMax, stats.ticks);
+            ticks += stats.ticks;
+            ticks2 += (double)stats.ticks * stats.ticks;
+            moves += stats.moves;
+            serialMs += stats.ms;
+        }
+        val n = cfg.sweepSeeds;
+        val mean = ticks / n;
+        fout << dispatch << "," << first.agvs << "," << first.capacity << "," << mixes[first.mix].second << "," << n
+             << "," << finished << "," << mean << "," << std::sqrt(max(0.0, ticks2 / n - mean * mean)) << ","
+             << makespanMax << "," << moves / max(1, delivered) << ","
+             << delivered / (ticks * SECONDS_PER_TICK / 3600) << "," << replans / ticks << endl;
+    }
+    fout.close();
+    cerr << "sweep runs=" << runs.size() << " threads=" << pool.size() << " wall ms=" << wallMs
+         << " serial ms=" << serialMs << " file=" << cfg.sweepFile << endl;
+
+    DEBUG("end sweep");
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+#include "config.hpp"
+#include "top.hpp"
+
+// greedy4simulate for every fleet size, capacity, order mix and generated order set of cfg, the runs spread over a
+// thread pool and share one solved graph; makespan and travel statistics per combination go to cfg.sweepFile
+void sweep(ref<Config> cfg);
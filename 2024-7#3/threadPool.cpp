@@ -0,0 +1,69 @@
+#include "threadPool.hpp"
+
+int resolveThreads(int threads) {
+    if (threads > 0) return threads;
+    return max(1, (int)std::thread::hardware_concurrency());
+}
+
+ThreadPool::ThreadPool(int threads) {
+    threads = resolveThreads(threads);
+    for (var i = 0; i < threads; i++) {
+        workers.emplace_back([this]() {
+            loop {
+                std::function<void()> job;
+                {
+                    std::unique_lock lock(mtx);
+                    jobReady.wait(lock, [this]() { return stopping || !jobs.empty(); });
+                    if (jobs.empty()) return;
+                    job = move(jobs.front());
+                    jobs.pop();
+                }
+                job();
+                {
+                    std::lock_guard lock(mtx);
+                    if (--pending == 0) allDone.notify_all();
+                }
+            }
+        });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock(mtx);
+        stopping = true;
+    }
+    jobReady.notify_all();
+    for (var &worker : workers) worker.join();
+}
+
+void ThreadPool::submit(std::function<void()> job) {
+    {
+        std::lock_guard lock(mtx);
+        jobs.push(move(job));
+        pending++;
+    }
+    jobReady.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock lock(mtx);
+    allDone.wait(lock, [this]() { return pending == 0; });
+}
+
+void ThreadPool::parallelFor(int n, ref<std::function<void(int)>> body, int grain) {
+    if (n <= 0) return;
+    grain = max(1, grain);
+    std::atomic<int> next = 0;
+    val chunks = (n + grain - 1) / grain;
+    for (var w = 0; w < min(size(), chunks); w++) {
+        submit([&]() {
+            loop {
+                val begin = next.fetch_add(grain);
+                if (begin >= n) return;
+                for (var i = begin; i < min(n, begin + grain); i++) body(i);
+            }
+        });
+    }
+    wait();
+}
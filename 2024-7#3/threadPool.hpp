@@ -0,0 +1,33 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "top.hpp"
+
+// fixed-size pool of workers, jobs run in submit order
+struct ThreadPool {
+    vector<std::thread> workers;
+    queue<std::function<void()>> jobs;
+    std::mutex mtx;
+    std::condition_variable jobReady;
+    std::condition_variable allDone;
+    int pending = 0;
+    bool stopping = false;
+    //
+    explicit ThreadPool(int threads = 0); // 0 -> hardware_concurrency
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+    ~ThreadPool();
+    //
+    int size() const { return workers.size(); }
+    void submit(std::function<void()> job);
+    void wait();
+    // run body(i) for i in [0, n), workers grab chunks of `grain` indices
+    void parallelFor(int n, ref<std::function<void(int)>> body, int grain = 1);
+};
+
+int resolveThreads(int threads);
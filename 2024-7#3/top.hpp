@@ -2,8 +2,11 @@
 
 #include <algorithm>
 #include <array>
+#include <bit>
+#include <chrono>
 #include <ctime>
 #include <fstream>
+#include <functional>
 #include <iostream>
 #include <queue>
 #include <random>
@@ -22,6 +25,8 @@ using std::mt19937, std::random_device, std::uniform_int_distribution, std::unif
 
 using std::reverse;
 
+const int INT_SOFT_MAX = 1e9 + 7;
+
 template <typename T> using matrix = vector<vector<T>>;
 
 template <typename T> using ref = const T &;
@@ -44,22 +49,28 @@ using pii = array<int, 2>;
             std::cerr << __FILE__ << "#" << __LINE__ << ": " << #X << " -> " << (X) << std::endl;                      \
     } while (0)
 
+// wall clock since construction
+struct Timer {
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+    //
+    void reset() { startTime = std::chrono::steady_clock::now(); }
+    double ms() const {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    }
+};
+
 // for agv schedule
 const string map_file = "map.txt";
 const string order_file = "order.txt";
+const string dist_cache_file = "map.dist";
 
 const string sa4lowerbound_file = "sa4lowerbound.txt";
 const string sa4lowerbound_path_file = "sa4lowerbound_path.txt";
 const string greedy4simulate_path_file = "greedy4simulate_path.txt";
+const string greedy4simulate_profile_file = "greedy4simulate_profile.json";
 
 const int MAX_AGV = 4;
 const int MAX_ORDER = 100;
 const int MAX_AGV_TASK = 5;
 
-const vector<pii> agvRestArea = {
-    {1, 1},
-    {2, 1},
-    {3, 1},
-    {4, 1},
-};
 const pii sendArea = {12, 2};
@@ -0,0 +1,165 @@
+#include "trajectory.hpp"
+
+#include <cstring>
+
+#include "graph.hpp"
+
+namespace {
+const char MAGIC[4] = {'A', 'G', 'V', 'T'};
+const int VERSION = 1;
+enum Code : uint8_t { End = 0, Stay = 1, Step = 2, Jump = 6 };
+
+void putInt(ofstream &fout, int32_t v) { fout.write(reinterpret_cast<const char *>(&v), sizeof(v)); }
+bool getInt(ifstream &fin, int32_t &v) { return (bool)fin.read(reinterpret_cast<char *>(&v), sizeof(v)); }
+} // namespace
+
+// TrajectoryWriter
+bool TrajectoryWriter::open(ref<string> file, int rows, int cols, int agvs) {
+    fout.open(file, std::ios::binary);
+    if (!fout) return false;
+    this->cols = cols;
+    last.assign(agvs, -1);
+    chunk.clear();
+    chunkTicks = 0;
+    fout.write(MAGIC, sizeof(MAGIC));
+    for (val v : {VERSION, rows, cols, agvs, CHUNK_TICKS}) putInt(fout, v);
+    return (bool)fout;
+}
+void TrajectoryWriter::write(ref<vector<pii>> positions) {
+    for (var idx = 0; idx < (int)last.size(); idx++) {
+        val [r, c] = positions[idx];
+        if (r < 0) {
+            chunk.push_back(End);
+            last[idx] = -1;
+            continue;
+        }
+        val id = v2id(r, c, cols);
+        var code = (uint8_t)Jump;
+        if (last[idx] != -1) {
+            val [lr, lc] = id2v(last[idx], cols);
+            if (id == last[idx]) code = Stay;
+            for (var i = 0; i < 4; i++) {
+                if (r == lr + dr[i] && c == lc + dc[i]) code = Step + i;
+            }
+        }
+        chunk.push_back(code);
+        for (var v = (uint32_t)id; code == Jump; v >>= 7) { // varint, 7 bits a byte, low first
+            chunk.push_back((v & 0x7f) | (v >= 0x80 ? 0x80 : 0));
+            if (v < 0x80) break;
+        }
+        last[idx] = id;
+    }
+    if (++chunkTicks == CHUNK_TICKS) flush();
+}
+void TrajectoryWriter::flush() {
+    if (chunkTicks == 0) return;
+    putInt(fout, chunkTicks);
+    putInt(fout, chunk.size());
+    fout.write(reinterpret_cast<const char *>(chunk.data()), chunk.size());
+    chunk.clear();
+    chunkTicks = 0;
+    std::fill(last.begin(), last.end(), -1);
+}
+bool TrajectoryWriter::close() {
+    flush();
+    fout.close();
+    return !fout.fail();
+}
+// TrajectoryReader
+bool TrajectoryReader::open(ref<string> file) {
+    fin.open(file, std::ios::binary);
+    char magic[sizeof(MAGIC)];
+    int32_t version, chunkTicks;
+    if (!fin.read(magic, sizeof(magic)) || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0) return false;
+    if (!getInt(fin, version) || version != VERSION) return false;
+    if (!getInt(fin, rows) || !getInt(fin, cols) || !getInt(fin, agvs) || !getInt(fin, chunkTicks)) return false;
+    last.assign(max(0, agvs), -1);
+    ticksLeft = 0;
+    broken = false;
+    return agvs >= 0 && rows > 0 && cols > 0 && (int64_t)rows * cols <= INT32_MAX;
+}
+bool TrajectoryReader::next(vector<pii> &positions) {
+    // every way out but a clean end of the file marks it broken
+    fun fail = [&]() {
+        broken = true;
+        return false;
+    };
+    if (ticksLeft == 0) {
+        // a finished chunk has no bytes left over
+        if (at != chunk.size()) return fail();
+        int32_t ticks, bytes;
+        if (!getInt(fin, ticks)) return fin.gcount() == 0 && fin.eof() ? false : fail();
+        if (!getInt(fin, bytes) || ticks <= 0 || bytes < 0) return fail();
+        chunk.resize(bytes);
+        if (!fin.read(reinterpret_cast<char *>(chunk.data()), bytes)) return fail();
+        at = 0;
+        ticksLeft = ticks;
+        std::fill(last.begin(), last.end(), -1);
+    }
+    positions.resize(agvs);
+    for (var idx = 0; idx < agvs; idx++) {
+        if (at >= chunk.size()) return fail();
+        val code = chunk[at++];
+        var id = last[idx];
+        if (code == Jump) {
+            uint32_t v = 0;
+            for (var shift = 0;; shift += 7) {
+                if (at >= chunk.size() || shift > 28) return fail();
+                val b = chunk[at++];
+                v |= (uint32_t)(b & 0x7f) << shift;
+                if (!(b & 0x80)) break;
+            }
+            if (v >= (uint32_t)rows * cols) return fail();
+            id = v;
+        } else if (code == End) {
+            id = -1;
+        } else if (code >= Step && code < Jump && id != -1) {
+            val [r, c] = id2v(id, cols);
+            val nr = r + dr[code - Step], nc = c + dc[code - Step];
+            if (nr < 0 || nr >= rows || nc < 0 || nc >= cols) return fail();
+            id = v2id(nr, nc, cols);
+        } else if (code != Stay || id == -1) {
+            return fail(); // no code, or a move from nowhere
+        }
+        last[idx] = id;
+        positions[idx] = id == -1 ? pii{-1, -1} : id2v(id, cols);
+    }
+    ticksLeft--;
+    return true;
+}
+//
+
+bool isTrajectoryFile(ref<string> file) { return file.size() >= 5 && file.compare(file.size() - 5, 5, ".traj") == 0; }
+
+bool trajectory2Text(ref<string> file, std::ostream &out) {
+    TrajectoryReader reader;
+    if (!reader.open(file)) return false;
+    matrix<pii> paths(reader.agvs);
+    vector<pii> positions;
+    while (reader.next(positions)) {
+        for (var idx = 0; idx < reader.agvs; idx++) {
+            if (positions[idx][0] >= 0) paths[idx].push_back(positions[idx]);
+        }
+    }
+    if (!reader.ok()) return false;
+    for (val &path : paths) {
+        for (val p : path) out << p[0] << " " << p[1] << " ";
+        out << "\n";
+    }
+    return (bool)out;
+}
+
+bool writeTrajectory(ref<string> file, int rows, int cols, ref<matrix<pii>> paths) {
+    TrajectoryWriter writer;
+    if (!writer.open(file, rows, cols, paths.size())) return false;
+    size_t ticks = 0;
+    for (val &path : paths) ticks = max(ticks, path.size());
+    vector<pii> positions(paths.size());
+    for (size_t t = 0; t < ticks; t++) {
+        for (size_t idx = 0; idx < paths.size(); idx++) {
+            positions[idx] = t < paths[idx].size() ? paths[idx][t] : pii{-1, -1};
+        }
+        writer.write(positions);
+    }
+    return writer.close();
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+
+#include "top.hpp"
+
+// binary agv trajectories, written tick by tick while a run goes on instead of kept until its end
+// header: "AGVT", then version, rows, cols, agvs and ticks per chunk as int32; then chunks of `ticks` ticks as
+// int32 ticks, int32 bytes and the bytes; all little-endian as the hosts this runs on
+// per tick one code per agv, relative to its cell the tick before: 0 no position (its path is over), 1 stays,
+// 2 + i steps by dr[i], dc[i], 6 jumps to the cell id in the varint that follows; the first tick of a chunk jumps, so
+// every chunk decodes on its own
+struct TrajectoryWriter {
+    static constexpr int CHUNK_TICKS = 256;
+    //
+    ofstream fout;
+    int cols = 0;
+    vector<int> last;     // per agv, cell id the tick before in this chunk, -1 at a chunk start or after its end
+    vector<uint8_t> chunk; // ticks not flushed yet
+    int chunkTicks = 0;
+    //
+    bool open(ref<string> file, int rows, int cols, int agvs);
+    bool isOpen() const { return fout.is_open(); }
+    void write(ref<vector<pii>> positions); // one tick, {-1, -1} for an agv whose path is over
+    bool close();                           // flush the last chunk
+    void flush();
+};
+
+struct TrajectoryReader {
+    ifstream fin;
+    int rows = 0, cols = 0, agvs = 0;
+    vector<uint8_t> chunk;
+    size_t at = 0;
+    int ticksLeft = 0; // in the current chunk
+    vector<int> last;
+    bool broken = false;
+    //
+    bool open(ref<string> file); // false if it is no trajectory
+    bool next(vector<pii> &positions); // one tick, false at the end or on a broken file
+    bool ok() const { return !broken; } // after next() returned false: the file ended where a chunk did
+};
+
+bool isTrajectoryFile(ref<string> file); // a path file named *.traj is written as a trajectory, else as text
+
+// one line per agv of its cells, "r c r c ...", as the text path files; false and nothing written on a broken file
+bool trajectory2Text(ref<string> file, std::ostream &out);
+// paths of different lengths, each agv's stops after its last cell
+bool writeTrajectory(ref<string> file, int rows, int cols, ref<matrix<pii>> paths);
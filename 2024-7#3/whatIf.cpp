@@ -0,0 +1,69 @@
+#include "whatIf.hpp"
+
+#include "greedy4simulate.hpp"
+#include "threadPool.hpp"
+
+void whatIf(ref<Config> cfg) {
+    DEBUG("begin whatIf");
+
+    GraphG G;
+    Order O;
+    if (!G.input(cfg.mapFile)) {
+        DEBUG("map file error");
+        return;
+    }
+    G.solveShortestPath(cfg.apspOptions());
+    // branches share nothing that is written while they run
+    var runCfg = cfg;
+    runCfg.pathFile = "";
+    runCfg.profileFile = "";
+    runCfg.orderStream = "";
+
+    SimState prefix;
+    if (!cfg.resume.empty()) {
+        if (!prefix.load(cfg.resume, G)) {
+            cerr << "cannot read checkpoint " << cfg.resume << endl;
+            return;
+        }
+        if (prefix.planner != cfg.planner) {
+            cerr << "checkpoint " << cfg.resume << " was made with the other --planner" << endl;
+            return;
+        }
+    } else if (!O.input(cfg.orderFile, cfg.orders) || !prefix.init(runCfg, G, O)) {
+        DEBUG("order file error");
+        return;
+    }
+    for (val idx : cfg.downAgvs) {
+        if (idx < 0 || idx >= prefix.F.size) {
+            cerr << "no agv " << idx << " in a fleet of " << prefix.F.size << endl;
+            return;
+        }
+    }
+    Timer prefixTimer;
+    greedy4simulate(runCfg, G, prefix, cfg.forkAt);
+    val prefixMs = prefixTimer.ms();
+    if (!cfg.checkpoint.empty() && !prefix.save(cfg.checkpoint, G)) cerr << "cannot write " << cfg.checkpoint << endl;
+
+    // -1 -> nobody breaks down
+    vector<int> down = {-1};
+    down.insert(down.end(), cfg.downAgvs.begin(), cfg.downAgvs.end());
+    vector<SimStats> stats(down.size());
+    ThreadPool pool(cfg.threads);
+    Timer wall;
+    pool.parallelFor(down.size(), [&](int i) {
+        var branch = prefix;
+        if (down[i] != -1) branch.breakDown(down[i]);
+        stats[i] = greedy4simulate(runCfg, G, branch, cfg.ticks);
+    });
+    val wallMs = wall.ms();
+
+    cerr << "what-if fork=" << prefix.clock << " prefix ms=" << prefixMs << " branches=" << down.size()
+         << " threads=" << pool.size() << " wall ms=" << wallMs << endl;
+    for (var i = 0; i < (int)down.size(); i++) {
+        cerr << "  down=" << (down[i] == -1 ? "none" : std::to_string(down[i])) << " ticks=" << stats[i].ticks
+             << " delivered=" << stats[i].delivered << "/" << prefix.O.orders << " moves=" << stats[i].moves
+             << " finished=" << stats[i].finished << endl;
+    }
+
+    DEBUG("end whatIf");
+}
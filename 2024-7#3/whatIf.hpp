@@ -0,0 +1,9 @@
+#pragma once
+
+#include "config.hpp"
+#include "top.hpp"
+
+// what-if branches of one greedy4simulate run: the shared prefix up to cfg.forkAt is simulated once, or read from the
+// checkpoint cfg.resume, then forked into the unchanged run and one run per agv of cfg.downAgvs with that agv broken
+// down from there on; the branches go on in parallel over a thread pool and are reported side by side
+void whatIf(ref<Config> cfg);
@@ -0,0 +1,104 @@
+#pragma once
+
+// the one on-disk format for all-pairs distance caches, shared by 2024-7#2/sa, 2024-7#3 and 2024-11#3
+// a 64-byte header, then entries * entrySize bytes of the raw table; the header fills one cache line, so a mapped
+// table stays as aligned as the mapping
+// self-contained on purpose: include it before a project header that redefines keywords
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <string>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+struct DistCacheHeader {
+    static constexpr uint32_t MAGIC = 0x43444741; // "AGDC"
+    static constexpr uint32_t VERSION = 1;
+    //
+    uint32_t magic = MAGIC;
+    uint32_t version = VERSION;
+    uint64_t hash = 0; // gridHash of the map the table belongs to
+    int32_t rows = 0;
+    int32_t cols = 0;
+    uint32_t entrySize = 0; // bytes per entry
+    uint32_t layout = 0;    // how the owner lays entries out, e.g. its tile edge; 0 for a plain row-major table
+    uint64_t entries = 0;
+    uint8_t pad[24] = {};
+    //
+    size_t bytes() const { return entries * entrySize; }
+    bool operator==(const DistCacheHeader &other) const {
+        return magic == other.magic && version == other.version && hash == other.hash && rows == other.rows &&
+               cols == other.cols && entrySize == other.entrySize && layout == other.layout &&
+               entries == other.entries;
+    }
+};
+static_assert(sizeof(DistCacheHeader) == 64);
+
+// fnv-1a over the sizes and cells of a grid, any vector of rows of chars or cell codes
+template <typename Grid> uint64_t gridHash(const Grid &grid) {
+    uint64_t h = 1469598103934665603ULL;
+    auto mix = [&](uint64_t v) {
+        h ^= v;
+        h *= 1099511628211ULL;
+    };
+    mix(grid.size());
+    for (const auto &row : grid) {
+        mix(row.size());
+        for (auto cell : row) mix((uint64_t)cell);
+    }
+    return h;
+}
+
+// map the table behind `expect` copy-on-write, writes to it never reach the file
+// nullptr if the file is missing, has another size or belongs to another map or layout
+inline void *loadDistCache(const std::string &file, const DistCacheHeader &expect, std::shared_ptr<void> &storage) {
+    const size_t fileBytes = sizeof(DistCacheHeader) + expect.bytes();
+#ifndef _WIN32
+    const auto fd = open(file.c_str(), O_RDONLY);
+    if (fd < 0) return nullptr;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size != fileBytes) {
+        close(fd);
+        return nullptr;
+    }
+    void *base = mmap(nullptr, fileBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) return nullptr;
+    if (!(*static_cast<const DistCacheHeader *>(base) == expect)) {
+        munmap(base, fileBytes);
+        return nullptr;
+    }
+    storage = std::shared_ptr<void>(base, [fileBytes](void *p) { munmap(p, fileBytes); });
+    return static_cast<char *>(base) + sizeof(DistCacheHeader);
+#else
+    std::ifstream fin(file, std::ios::binary);
+    DistCacheHeader header;
+    if (!fin.read(reinterpret_cast<char *>(&header), sizeof(header)) || !(header == expect)) return nullptr;
+    // a copy instead of a mapping, aligned as the mapping would be
+    void *data = std::aligned_alloc(64, (expect.bytes() + 64) / 64 * 64);
+    storage = std::shared_ptr<void>(data, std::free);
+    if (!fin.read(static_cast<char *>(data), expect.bytes())) return nullptr;
+    return data;
+#endif
+}
+
+// write aside and rename, a concurrent reader never maps a half-written table
+inline bool saveDistCache(const std::string &file, const DistCacheHeader &header, const void *data) {
+    const std::string tmp = file + ".tmp";
+    {
+        std::ofstream fout(tmp, std::ios::binary | std::ios::trunc);
+        if (!fout) return false;
+        fout.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        fout.write(static_cast<const char *>(data), header.bytes());
+        if (!fout) return false;
+    }
+    return std::rename(tmp.c_str(), file.c_str()) == 0;
+}
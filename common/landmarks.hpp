@@ -0,0 +1,83 @@
+#pragma once
+
+// alt landmarks, shared by 2024-7#3 (Landmarks in landmarks.hpp) and 2024-11#3 (Landmarks in alt.hpp)
+// bfs rows from k landmarks spread out by farthest-point selection; |d(l, u) - d(l, v)| <= d(u, v) for every
+// landmark l, so the max over them is an admissible lower bound, from k rows over the open cells instead of a table
+// self-contained on purpose: include it before a project header that redefines keywords
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+struct LandmarkRows {
+    static constexpr uint16_t UNREACHABLE = 0xffff;
+    //
+    int32_t slots = 0;
+    std::vector<int32_t> cells; // landmark cell ids
+    std::vector<uint16_t> rows; // k * slots
+    //
+    bool enabled() const { return !cells.empty(); }
+    size_t bytes() const { return rows.size() * sizeof(uint16_t); }
+
+    // adj[cell] lists the open neighbours of a cell, slotOf and cellOf number the open cells densely
+    template <typename Adj, typename SlotOf, typename CellOf>
+    void build(const Adj &adj, const SlotOf &slotOf, const CellOf &cellOf, int32_t k) {
+        slots = (int32_t)cellOf.size();
+        cells.clear();
+        rows.clear();
+        if (slots == 0) return;
+        k = std::min(k, slots);
+        std::vector<uint16_t> row(slots);
+        std::vector<int32_t> q(slots);
+        auto bfs = [&](int32_t start) {
+            std::fill(row.begin(), row.end(), UNREACHABLE);
+            int32_t head = 0, tail = 0;
+            row[slotOf[start]] = 0;
+            q[tail++] = start;
+            while (head < tail) {
+                const int32_t u = q[head++];
+                // saturating keeps the bound admissible on maps with paths past uint16, only looser there
+                const uint16_t du = row[slotOf[u]];
+                const uint16_t dn = du + 1 < UNREACHABLE ? du + 1 : UNREACHABLE - 1;
+                for (const int32_t v : adj[u]) {
+                    uint16_t &dv = row[slotOf[v]];
+                    if (dv != UNREACHABLE) continue;
+                    dv = dn;
+                    q[tail++] = v;
+                }
+            }
+        };
+        // start from the cell farthest from an arbitrary one, then keep taking the cell farthest from its nearest
+        // landmark; cells no landmark reaches count as farthest, so every component gets one
+        auto farthest = [](const std::vector<int32_t> &score) {
+            return (int32_t)(std::max_element(score.begin(), score.end()) - score.begin());
+        };
+        bfs(cellOf[0]);
+        std::vector<int32_t> nearest(slots);
+        for (int32_t s = 0; s < slots; s++) nearest[s] = row[s] == UNREACHABLE ? -1 : row[s];
+        int32_t next = farthest(nearest);
+        std::fill(nearest.begin(), nearest.end(), INT32_MAX);
+        for (int32_t i = 0; i < k; i++) {
+            bfs(cellOf[next]);
+            cells.push_back(cellOf[next]);
+            rows.insert(rows.end(), row.begin(), row.end());
+            for (int32_t s = 0; s < slots; s++) {
+                if (row[s] != UNREACHABLE) nearest[s] = std::min<int32_t>(nearest[s], row[s]);
+            }
+            next = farthest(nearest);
+        }
+    }
+
+    // slots, -1 if the landmarks prove b unreachable from a
+    int32_t bound(int32_t a, int32_t b) const {
+        if (a == b) return 0;
+        int32_t best = 0;
+        for (size_t l = 0; l < cells.size(); l++) {
+            const uint16_t da = rows[l * slots + a], db = rows[l * slots + b];
+            if ((da == UNREACHABLE) != (db == UNREACHABLE)) return -1;
+            if (da != UNREACHABLE) best = std::max<int32_t>(best, std::abs(da - db));
+        }
+        return best;
+    }
+};